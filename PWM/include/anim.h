@@ -0,0 +1,36 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "spsc.h"
+
+// Frame-paced LED effects for the NeoTrellis keys. A timer renders each
+// frame into the pixel framebuffer in fixed point and flushes it as LED
+// class traffic, which the seesaw engine budgets and ranks below keypad
+// reads. A frame is skipped while the previous one is still queued.
+#define ANIM_FPS            40
+#define ANIM_FRAME_US       (1000000 / ANIM_FPS)
+#define ANIM_RIPPLES        4
+
+// Call on core 1 (cores_init): frames run on its alarm pool.
+void anim_init(void);
+
+// Off hands the LEDs back to whoever paints them directly (sequencer,
+// arpeggiator); on clears all effects and takes them over.
+void anim_enable(bool on);
+bool anim_enabled(void);
+
+// Held keys breathe in their color and throw a ripple; released keys fade.
+void anim_key(int idx, bool pressed);
+
+// Same, queued for the next frame instead of taking the effect state with
+// interrupts off. Single producer: the keypad path in the main loop.
+bool anim_post_key(int idx, bool pressed);
+const spsc_t *anim_key_queue(void);
+
+// Rainbow across the whole grid for a number of frames, fading out at the end.
+void anim_rainbow(uint16_t frames);
+
+// Master brightness, Q8 (256 = full), applied before gamma.
+void anim_set_brightness(uint16_t q8);
+
+void anim_print(void);
@@ -0,0 +1,47 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+// Arpeggiator over the held keys. Notes are scheduled from a hardware
+// alarm at microsecond resolution, synced to the sequencer tempo.
+#define ARP_TAG         0x50        // audio_note_on tag for the arp voice
+
+typedef enum {
+    ARP_UP,
+    ARP_DOWN,
+    ARP_UPDOWN,
+    ARP_RANDOM,
+    ARP_MODE_COUNT
+} arp_mode_t;
+
+typedef enum {
+    ARP_RATE_4,             // quarter notes
+    ARP_RATE_8,
+    ARP_RATE_8T,
+    ARP_RATE_16,
+    ARP_RATE_16T,
+    ARP_RATE_32,
+    ARP_RATE_COUNT
+} arp_rate_t;
+
+void arp_start(void);
+void arp_stop(void);
+
+void arp_set_mode(arp_mode_t m);
+void arp_set_rate(arp_rate_t r);
+void arp_set_latch(bool on);
+arp_mode_t arp_mode(void);
+arp_rate_t arp_rate(void);
+bool arp_latch(void);
+
+// gate is the note length as a fraction of the step in Q8 (256 = legato),
+// swing delays every other step by up to half a step, Q8 of that half.
+void arp_set_gate(uint16_t gate_q8);
+void arp_set_swing(uint16_t swing_q8);
+
+// Key handler for arp mode; keeps the held-key mask up to date.
+void arp_key(int idx, bool pressed);
+
+// Main-loop side: lights the keys in the chord, only touching changed pixels.
+void arp_update_leds(void);
+void arp_print(void);
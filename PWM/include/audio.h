@@ -0,0 +1,55 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "pitch.h"
+#include "spsc.h"
+
+// PWM "DAC" on the buzzer pin. The slice runs at a fixed carrier and DMA
+// reloads the compare level once per wrap, so one wrap == one audio sample.
+#define AUDIO_PIN           15
+#define AUDIO_SYS_CLK       150000000   // RP2350 runs at 150 MHz
+#define AUDIO_PWM_DIV       2
+#define AUDIO_PWM_TOP       2047        // 11-bit levels
+#define AUDIO_SAMPLE_RATE   (AUDIO_SYS_CLK / (AUDIO_PWM_DIV * (AUDIO_PWM_TOP + 1)))  // ~36.6 kHz
+
+// Samples per DMA block. Control-rate values (gain, pitch, ...) are picked
+// up once per block and ramped linearly across it.
+#define AUDIO_BLOCK         64
+#define AUDIO_BLOCK_RATE    (AUDIO_SAMPLE_RATE / AUDIO_BLOCK)   // ~572 Hz
+
+// Gain is Q16: 0x10000 == full scale.
+#define AUDIO_GAIN_ONE      0x10000
+
+#define AUDIO_VOICES        4
+
+void audio_init(void);
+
+// Start a note on a free voice (or steal the oldest). tag identifies the note
+// for audio_note_off, e.g. the key index. Each source owns its own range:
+// keys 0x00.., seq 0x40.., arp 0x50, looper 0x60.., MIDI in 0x100 | note,
+// SMF player 0x180 | note. Returns the voice used.
+int  audio_note_on(uint16_t tag, int32_t pitch);
+void audio_note_off(uint16_t tag);
+void audio_all_notes_off(void);
+
+// Portamento: a voice slides from its previous pitch to the new one over ms.
+// 0 = jump.
+void audio_set_glide_ms(uint16_t ms);
+
+// Vibrato LFO shared by all voices. rate in 1/100 Hz, depth in pitch units.
+void audio_set_vibrato(uint16_t rate_centihz, int32_t depth);
+
+// Pitch-bend offset added to every voice, in pitch units.
+void audio_set_bend(int32_t offset);
+
+// Target gain for the renderer. Safe to call from any context; the renderer
+// ramps from its current gain to this value over the next block.
+void audio_set_target_gain(uint32_t gain_q16);
+
+// Lock-free note on/off for a single producer outside the audio IRQ (the
+// main loop). The event is applied at the start of the next block (<2 ms);
+// false if the queue was full and the event was dropped.
+bool audio_post_note(uint16_t tag, int32_t pitch, bool on);
+void audio_post_all_off(void);
+uint32_t audio_post_dropped(void);
+const spsc_t *audio_post_queue(void);
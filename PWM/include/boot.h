@@ -0,0 +1,15 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+// Boot timeline. The LCD comes up on core 1 (cores_init) while core 0
+// brings up audio, MIDI and the NeoTrellis, and both cores stamp a shared
+// timeline so time-to-first-note can be compared across builds.
+#define BOOT_MARKS  24      // per core
+
+// Records stage at the current time. Safe from either core; each core
+// writes only its own slots.
+void boot_mark(const char *stage);
+
+// Timeline of both cores in time order, with the gap to the previous mark.
+void boot_print(void);
@@ -0,0 +1,63 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+
+// Core 0 is the real-time core: audio DMA IRQ, seesaw engine, keypad
+// decode, MIDI, USB and the console. Core 1 is the UI core: LCD init and
+// redraws, LED animation frames and formatting the key log. Key edges
+// reach core 1 through SPSC rings; core 1 hands work back to core 0
+// (anything that touches the I2C engine) by ringing an SIO doorbell, and
+// its log lines through a ring, since TinyUSB is only ever driven by
+// core 0. The SIO FIFO is left to the flash lockout.
+
+// Hardware spinlocks for the state both cores write.
+enum {
+    CORES_LOCK_FB,          // NeoPixel framebuffer dirty state
+    CORES_LOCK_ANIM,        // animation effects
+    CORES_LOCK_COUNT
+};
+
+// Work core 1 hands to core 0.
+enum {
+    CORES_MSG_LED_SHOW,     // flush the framebuffer
+    CORES_MSG_COUNT
+};
+
+// Measured work, each written only by the context that owns it.
+enum {
+    CORES_LOAD_AUDIO,       // core 0, DMA IRQ
+    CORES_LOAD_KEYPAD,      // core 0, decode and key handler
+    CORES_LOAD_ANIM,        // core 1, frame timer
+    CORES_LOAD_LCD,         // core 1, LCD_task
+    CORES_LOAD_COUNT
+};
+
+// Claims the locks and doorbells, takes core 0's doorbell IRQ and
+// launches core 1, which starts its own timers, then brings up the LCD
+// and runs the UI loop.
+// Call first thing in main.
+void cores_init(void);
+bool cores_lcd_ready(void);
+
+spin_lock_t *cores_lock(int which);
+
+// Runs msg on core 0: from core 1 it rings the message's doorbell, and a
+// ring still pending absorbs the new one; on core 0 it runs in place.
+// False only for an unknown message.
+bool cores_send(uint32_t msg);
+
+// Core 1's alarm pool; timers added there fire on core 1.
+alarm_pool_t *cores_ui_pool(void);
+
+// printf for code that may run on core 1. There the line is queued (and
+// dropped if the ring is full) for cores_log_task to print on core 0.
+#define CORES_LOG_LINE  64
+#define CORES_LOG_LINES 16
+void cores_log(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+void cores_log_task(void);
+
+void cores_load_add(int load, uint32_t us);
+// Busy share of each core since the last call, per load.
+void cores_print(void);
@@ -0,0 +1,37 @@
+#ifndef KNOBS_H
+#define KNOBS_H
+
+#include <stdint.h>
+
+// Knobs sit on consecutive ADC channels and are sampled round-robin by
+// DMA into a small ring, so reading one never touches the ADC.
+#define KNOB_ADC_FIRST  4       // GPIO 44
+#define KNOB_PIN(chan)  (40 + (chan))
+
+enum {
+    KNOB_SWING,                 // ADC 4 / GPIO 44
+    KNOB_VOLUME,                // ADC 5 / GPIO 45
+    KNOB_BEND,                  // ADC 6 / GPIO 46
+    KNOB_GATE,                  // ADC 7 / GPIO 47
+    KNOB_COUNT
+};
+
+// Initializes the ADC hardware and DMA engine.
+// Call this once inside main() before the loop.
+void knobs_init(void);
+
+// Raw knob position 0..4095, with a small deadband so ADC noise
+// does not show up as constant tiny changes.
+uint16_t knob_raw(int knob);
+
+// Knob position as a Q16 gain (0 .. AUDIO_GAIN_ONE) with a square-law
+// taper and a dead zone at the bottom. Integer only.
+uint32_t knob_volume_gain(void);
+
+// Bend knob mapped to -range..+range with a detent around the center.
+int32_t knob_bend(int32_t range);
+
+// Any knob scaled linearly to lo..hi.
+int32_t knob_scaled(int knob, int32_t lo, int32_t hi);
+
+#endif
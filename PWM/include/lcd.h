@@ -7,6 +7,8 @@
 #define __LCD_H
 #include "stdlib.h"
 #include <stdint.h>
+#include <stdbool.h>
+#include "spsc.h"
 
 // shorthand notation for 8-bit and 16-bit unsigned integers
 typedef uint8_t u8;
@@ -84,6 +86,12 @@ void LCD_DrawString(u16 x,u16 y, u16 fc, u16 bg, const char *p, u8 size, u8 mode
 void LCD_start();
 void LCD_note(int c);
 
+// Queues a key edge for the screen and the key log; single producer.
+// LCD_task, on core 1, drains the queue and redraws once for the latest edge.
+bool LCD_post_key(int key, bool pressed);
+void LCD_task(void);
+const spsc_t *LCD_key_queue(void);
+
 //===========================================================================
 // C Picture data structure.
 //===========================================================================
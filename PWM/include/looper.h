@@ -0,0 +1,56 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+// Records key edges with microsecond timestamps and loops them, with
+// overdub layers. Playback is driven by a hardware alarm walking a sorted
+// event array, so fetching the next due event is O(1).
+#define LOOPER_CAPACITY     2048            // events in the loop (8 KB)
+#define LOOPER_STAGE        256             // events per overdub pass (1 KB)
+#define LOOPER_LAYERS       8
+#define LOOPER_MAX_US       ((1u << 24) - 1)    // ~16.7 s, see loop_event_t
+#define LOOPER_TAG_BASE     0x60            // audio tags, one per key
+
+// One event in 4 bytes. Time is in the top bits so sorting the raw words
+// sorts by time.
+//   [31:8] microseconds from loop start
+//   [7:5]  overdub layer
+//   [4]    1 = press, 0 = release
+//   [3:0]  key, 0..15: only the first tile's keys carry notes
+typedef uint32_t loop_event_t;
+
+#define LOOP_EVENT(t, layer, press, key) \
+    (((uint32_t)(t) << 8) | ((uint32_t)(layer) << 5) | ((uint32_t)(press) << 4) | ((uint32_t)(key) & 0xF))
+#define LOOP_EVENT_TIME(e)  ((e) >> 8)
+#define LOOP_EVENT_LAYER(e) (((e) >> 5) & 0x7)
+#define LOOP_EVENT_PRESS(e) (((e) >> 4) & 0x1)
+#define LOOP_EVENT_KEY(e)   ((e) & 0xF)
+
+typedef enum {
+    LOOPER_IDLE,
+    LOOPER_RECORDING,       // first pass, sets the loop length
+    LOOPER_PLAYING,
+    LOOPER_OVERDUBBING,
+    LOOPER_STOPPED,         // loop kept, not playing
+} looper_state_t;
+
+// Space steps IDLE -> RECORDING -> PLAYING <-> OVERDUBBING, and
+// STOPPED -> PLAYING from the loop start.
+void looper_advance(void);
+// Stops playback and keeps the loop (STOPPED). A first pass still
+// recording has no length yet, so it is dropped (IDLE).
+void looper_stop(void);
+void looper_clear(void);
+bool looper_undo(void);                 // drop the newest layer
+looper_state_t looper_state(void);
+
+// Snap events to a grid when played back (0 = off). Stored times are kept.
+void looper_set_quantize_us(uint32_t grid_us);
+
+// Key handler for looper mode: records the edge, then plays it as usual.
+// Keys past the tuning table (extra tiles) are ignored.
+void looper_key(int idx, bool pressed);
+
+// Main-loop side: closes an over-long first pass.
+void looper_poll(void);
+void looper_print(void);
@@ -0,0 +1,54 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// MIDI 1.0 byte-stream and USB-MIDI packet codec. No allocation, no SDK
+// dependencies: the parser keeps a few bytes of state and hands back
+// complete messages, so it runs equally in an IRQ, a task or on a host.
+
+#define MIDI_CHANNEL        0           // channel we send on (0 = "channel 1")
+#define MIDI_TAG(note)      ((uint16_t)(0x100 | ((note) & 0x7F)))   // audio tag for a MIDI note
+
+typedef struct {
+    uint8_t status;
+    uint8_t d1;
+    uint8_t d2;
+    uint8_t len;            // bytes on the wire including status, 1..3
+} midi_msg_t;
+
+typedef struct {
+    uint8_t status;         // status of the message being assembled, 0 = none
+    uint8_t data[2];
+    uint8_t need;           // data bytes the status wants
+    uint8_t have;
+    bool    in_sysex;
+} midi_parser_t;
+
+// Wire length of a message with this status, 0 for sysex/undefined.
+uint8_t midi_msg_len(uint8_t status);
+
+void midi_parser_reset(midi_parser_t *p);
+
+// Feed one byte. Handles running status and real-time bytes interleaved
+// anywhere; sysex is skipped. true when *out holds a complete message.
+bool midi_parse_byte(midi_parser_t *p, uint8_t b, midi_msg_t *out);
+
+// Serialize into out (room for 3 bytes). With running != NULL the status
+// byte is left out when it repeats. Returns the byte count.
+size_t midi_encode(const midi_msg_t *m, uint8_t *out, uint8_t *running);
+
+// USB-MIDI 1.0 event packets (cable number + code index, then 3 bytes).
+void midi_to_usb(const midi_msg_t *m, uint8_t cable, uint8_t pkt[4]);
+bool midi_from_usb(const uint8_t pkt[4], midi_msg_t *m);
+
+static inline midi_msg_t midi_note(uint8_t ch, uint8_t note, uint8_t vel, bool on) {
+    midi_msg_t m = { (uint8_t)((on ? 0x90 : 0x80) | (ch & 0x0F)), (uint8_t)(note & 0x7F), (uint8_t)(vel & 0x7F), 3 };
+    return m;
+}
+static inline bool midi_is_note_on(const midi_msg_t *m) {
+    return (m->status & 0xF0) == 0x90 && m->d2 != 0;
+}
+static inline bool midi_is_note_off(const midi_msg_t *m) {
+    return (m->status & 0xF0) == 0x80 || ((m->status & 0xF0) == 0x90 && m->d2 == 0);
+}
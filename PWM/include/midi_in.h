@@ -0,0 +1,11 @@
+#pragma once
+#include <stdint.h>
+#include "midi.h"
+
+// Routes received channel messages to the synth. Every MIDI transport calls
+// this from the main loop, which keeps the main loop the single producer of
+// the renderer's note queue.
+void midi_in_dispatch(const midi_msg_t *m);
+
+uint32_t midi_in_messages(void);
+uint32_t midi_in_notes(void);
@@ -4,9 +4,41 @@
 #include <stdint.h>
 #include <stdbool.h>
 
-#define NEOTRELLIS_LED_COUNT   16
+// Tiled arrays: up to 8 boards at consecutive seesaw addresses from
+// NEOTRELLIS_ADDR. Tile t sits at column t % TILES_X, row t / TILES_X, and
+// keys are numbered row-major across the whole grid, so a single board is
+// still keys 0..15.
+#ifndef NEOTRELLIS_TILES_X
+#define NEOTRELLIS_TILES_X     1
+#endif
+#ifndef NEOTRELLIS_TILES_Y
+#define NEOTRELLIS_TILES_Y     1
+#endif
+#define NEOTRELLIS_TILES       (NEOTRELLIS_TILES_X * NEOTRELLIS_TILES_Y)
+#define NEOTRELLIS_TILE_KEYS   16
+#define NEOTRELLIS_TILE_BYTES  (NEOTRELLIS_TILE_KEYS * 3)
+#define NEOTRELLIS_TILE_ADDR(t) (NEOTRELLIS_ADDR + (t))
+#define NEOTRELLIS_GRID_W      (4 * NEOTRELLIS_TILES_X)
+#define NEOTRELLIS_GRID_H      (4 * NEOTRELLIS_TILES_Y)
+
+_Static_assert(NEOTRELLIS_TILES >= 1 && NEOTRELLIS_TILES <= 8, "1 to 8 NeoTrellis tiles");
+
+#define NEOTRELLIS_LED_COUNT   (NEOTRELLIS_TILES * NEOTRELLIS_TILE_KEYS)
 #define NEOTRELLIS_BYTES       (NEOTRELLIS_LED_COUNT * 3)
 
+// Global key <-> (tile, key on that tile)
+static inline int neotrellis_key_at(int tile, int local) {
+    int x = (tile % NEOTRELLIS_TILES_X) * 4 + local % 4;
+    int y = (tile / NEOTRELLIS_TILES_X) * 4 + local / 4;
+    return y * NEOTRELLIS_GRID_W + x;
+}
+static inline int neotrellis_key_tile(int key) {
+    return (key / NEOTRELLIS_GRID_W / 4) * NEOTRELLIS_TILES_X + (key % NEOTRELLIS_GRID_W) / 4;
+}
+static inline int neotrellis_key_local(int key) {
+    return ((key / NEOTRELLIS_GRID_W) % 4) * 4 + (key % NEOTRELLIS_GRID_W) % 4;
+}
+
 // === Seesaw module IDs (from Adafruit Seesaw) ===
 // (Keep these #defines grouped here so you can adjust if needed.)
 #define SEESAW_STATUS_BASE     0x00
@@ -41,7 +73,37 @@
 
 
 
+// Probes every tile on each bus and routes it to the one it answers on.
+// Part of a full topology scan; call again after moving boards around.
+void neotrellis_assign_buses(void);
+
+// Boot discovery. Init restores bus routes and rates from the map saved in
+// flash if every device there still answers with the same HW_ID and
+// firmware version, and returns true. Otherwise, or with rescan set, it
+// scans both buses, routes the tiles and returns false; save the map once
+// the rates are negotiated.
+bool neotrellis_topology_init(bool rescan);
+void neotrellis_topology_save(void);
+bool neotrellis_topology_cached(void);
 bool neotrellis_reset(void);
+
+// Seesaw timing. Reset installs the default per-register table; init then
+// loads the calibrated read delays saved for this seesaw firmware, or with
+// calibrate set measures and saves them if there are none. Later resets
+// and topology rescans put the calibrated delays back over the table.
+bool neotrellis_timing_init(bool calibrate);
+bool neotrellis_calibrate(void);
+void neotrellis_timing_print(void);
+
+// Steps each bus with tiles on it up through 400 kHz, 700 kHz and 1 MHz,
+// verifying the link at each rate, and keeps the fastest stable one.
+// Returns the slowest bus's rate. Needs neopixel_begin first.
+uint32_t neotrellis_negotiate_speed(void);
+
+// Achieved LED frame and keypad poll throughput at every candidate rate.
+// Key edges that arrive meanwhile wait in the tiles' FIFOs.
+void neotrellis_bus_benchmark(void);
+
 bool neotrellis_status(uint8_t *hw_id, uint32_t *version);
 bool neopixel_begin(uint8_t internal_pin /* usually 3 */);
 bool neopixel_set_bulk(const uint8_t *rgb48);
@@ -49,19 +111,51 @@ bool neopixel_show(void);
 bool neotrellis_wait_ready(uint32_t timeout_ms);
 bool neopixel_set_one_and_show(int index, uint8_t r, uint8_t g, uint8_t b);
 bool neopixel_fill_all_and_show(uint8_t r, uint8_t g, uint8_t b);
+bool neopixel_set_pixel(int idx, uint8_t r, uint8_t g, uint8_t b);
+// Per-flush byte and transaction counts for the framebuffer.
+void neopixel_fb_print(void);
 bool trellis_keypad_begin(void);
 bool trellis_read_event(uint8_t *idx, bool *pressed);
 bool trellis_handle_events(void);
 
 bool neopixel_test_simple();
 bool neopixel_clear_all();
-void neotrellis_rainbow_startup(void);
 bool neotrellis_read_key_event(uint8_t *raw_key, uint8_t *edge);
 void neotrellis_poll_and_light(void);
 bool neotrellis_keypad_init(void);
 void set_led_for_idx(int idx, bool on);
 void neotrellis_clear_fifo(void);
 bool neotrellis_poll_buttons(int *idx_out);
+
+// Called for every key edge found by neotrellis_poll_buttons.
+// NULL restores the default (animate + play + LCD).
+typedef void (*neotrellis_key_handler_t)(int idx, bool pressed);
+void neotrellis_set_key_handler(neotrellis_key_handler_t fn);
+void neotrellis_play_key(int idx, bool pressed);
+
+// One decoded keypad edge. time_us is the INT edge when known, else the
+// time the FIFO read completed.
+typedef struct {
+    uint8_t  key;           // global key, 0..NEOTRELLIS_LED_COUNT-1
+    bool     pressed;
+    uint32_t time_us;
+} neotrellis_event_t;
+
+#define KEYPAD_BURST        8   // FIFO entries drained per transaction
+
+// Drains up to max events in a single I2C transaction. Returns the number
+// of events, or -1 on a bus error.
+int neotrellis_read_events(neotrellis_event_t *ev, int max);
+
+// Read the keypad only when INT says there are events, with a slow poll as
+// a fallback. Off = read KEYPAD_COUNT on every neotrellis_poll_buttons call.
+#define KEYPAD_FALLBACK_MS  250
+void neotrellis_keypad_irq_init(void);
+void neotrellis_keypad_set_irq(bool on);
+bool neotrellis_keypad_irq(void);
+// I2C transactions per second since the last call, INT->events latency,
+// and per-tile reads, events and bus time.
+void neotrellis_keypad_print(void);
 // bool neotrellis_poll_buttons(void);
 
 static bool key_is_down[16] = { false };   // our debounced view of each key
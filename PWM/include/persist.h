@@ -0,0 +1,23 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+// Small settings store in the last flash sector, well clear of the image.
+// Records are keyed by id; each one carries its own length and CRC, so a
+// record from an older layout is simply not found.
+#define PERSIST_MAX_RECORD  512
+
+enum {
+    PERSIST_SEESAW_TIMING = 1,
+    PERSIST_TOPOLOGY = 2,
+};
+
+// Copies record id into buf. False if missing, corrupt or not exactly len.
+bool persist_load(uint8_t id, void *buf, uint16_t len);
+
+// Rewrites the sector with record id replaced. Interrupts are off and core 1
+// is paused for the erase and program (tens of ms), so call it at boot or
+// from the console.
+bool persist_save(uint8_t id, const void *buf, uint16_t len);
+
+void persist_print(void);
@@ -0,0 +1,17 @@
+#pragma once
+#include <stdint.h>
+
+// Pitch is a signed count of 1/256 cents above MIDI note 0 (C-1, 8.18 Hz).
+// Working in this log domain makes glide, vibrato and bend plain adds.
+#define PITCH_CENT          256
+#define PITCH_SEMITONE      (100 * PITCH_CENT)
+#define PITCH_OCTAVE        (1200 * PITCH_CENT)
+#define PITCH_MIDI(n)       ((int32_t)(n) * PITCH_SEMITONE)
+#define PITCH_MAX           PITCH_MIDI(127)
+
+// Oscillator phase increment for a pitch. Table lookup plus one linear
+// interpolation, no powf; meant for control rate, not per sample.
+uint32_t pitch_to_inc(int32_t pitch);
+
+// One cycle of sine in Q15, for LFOs. phase is a full 32-bit turn.
+int32_t pitch_lfo_sine(uint32_t phase);
@@ -0,0 +1,31 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+// Cooperative scheduler for core 0's main loop. Periodic tasks run in
+// deadline order; poll tasks run on every pass, and a pass happens on
+// every interrupt. When nothing is due the core sleeps in WFI until the
+// next deadline, which a hardware timer alarm wakes it for, or until any
+// other interrupt.
+#define SCHED_TASKS     12
+#define SCHED_POLL      0u              // period: every pass
+#define SCHED_ONCE      UINT32_MAX      // period: once, at the sched_at deadline
+
+typedef void (*sched_fn_t)(void);
+
+// Returns the task id, or -1 if the table is full. A periodic task first
+// runs one period from now.
+int sched_add(const char *name, sched_fn_t fn, uint32_t period_us);
+
+// Sets the next deadline (time_us_32 time) of a task; arms a SCHED_ONCE one.
+void sched_at(int id, uint32_t deadline_us);
+
+// From an IRQ that left work for a poll task: the next WFI falls through.
+void sched_kick(void);
+
+// Runs the loop; never returns.
+void sched_run(void);
+
+// Per-task runs, late-start jitter, run time and overruns, and the share
+// of time core 0 spent in WFI, since the last call.
+void sched_print(void);
@@ -16,16 +16,184 @@
 #define NEOTRELLIS_SCL       5
 #endif
 
+// Second controller, so tiles can be split across two buses. Its pins
+// must be on i2c1.
+#ifndef NEOTRELLIS_I2C_B
+#define NEOTRELLIS_I2C_B     i2c1
+#endif
+#ifndef NEOTRELLIS_SDA_B
+#define NEOTRELLIS_SDA_B     2
+#endif
+#ifndef NEOTRELLIS_SCL_B
+#define NEOTRELLIS_SCL_B     3
+#endif
+
+#define SEESAW_BUSES         2
+
+// Seesaw INT output: open drain, held low while the keypad FIFO has events
+#ifndef NEOTRELLIS_INT
+#define NEOTRELLIS_INT       6
+#endif
+
 // Default NeoTrellis (seesaw) 7-bit I2C address
 #ifndef NEOTRELLIS_ADDR
 #define NEOTRELLIS_ADDR      0x2E
 #endif
 
+#define SEESAW_READ_DELAY_US 300     // register select -> data ready, if not in the table
+#define SEESAW_MAX_READ      64
+
+// QoS classes. Picked keypad first, then normal, then LED, at every
+// transaction boundary. Zero-initialized descriptors are normal.
+enum {
+    SEESAW_PRIO_NORMAL,
+    SEESAW_PRIO_KEYPAD,
+    SEESAW_PRIO_LED,
+    SEESAW_PRIO_COUNT
+};
+
+// Self-healing transport. A failed attempt is retried, up to
+// SEESAW_RETRIES more times within SEESAW_RETRY_BUDGET_US of the first.
+// A transaction that stops making progress for SEESAW_XFER_TIMEOUT_US (plus
+// time per byte), lost arbitration, or an SDA line held low while the bus
+// is idle triggers recovery: nine SCL pulses, a STOP, and a controller
+// reinit. A settle hold or read delay whose alarm cannot be armed, or
+// never fires, goes on without it rather than parking the bus.
+#define SEESAW_RETRIES          3
+#define SEESAW_RETRY_BUDGET_US  10000
+#define SEESAW_RETRY_BACKOFF_US 200
+#define SEESAW_XFER_TIMEOUT_US  2000
+#define SEESAW_WATCHDOG_MS      2       // armed only while a transaction runs
+
+// Per module/register error counters; the table keeps the first
+// SEESAW_OP_SLOTS - 1 registers seen and pools the rest in the last slot.
+typedef struct {
+    uint8_t  module;
+    uint8_t  reg;
+    uint32_t count;             // completed, after retries
+    uint32_t nacks;             // attempts the chip did not acknowledge
+    uint32_t bus_errors;        // attempts lost to timeouts or arbitration
+    uint32_t retries;
+    uint32_t failed;            // gave up
+} seesaw_op_stats_t;
+
+#define SEESAW_OP_SLOTS      24
+
+// A class's budget is a share of what its bus carries in one window at
+// the current rate (9 clocks per byte), so it follows the negotiated
+// speed. Half the bus for LEDs is 555 B per window at 400 kHz, room for
+// an 8-tile frame, and leaves keypad reads the other half even at the
+// 100 kHz fallback.
+#define SEESAW_QOS_WINDOW_US 25000      // one LED animation frame
+#define SEESAW_LED_SHARE     50         // percent of the bus
+
+typedef struct {
+    uint32_t done;
+    uint32_t bytes;
+    uint32_t wait_max_us;       // submit -> start
+    uint32_t latency_max_us;    // submit -> done
+    uint32_t passed_over;       // still queued when a higher class went first
+    uint32_t budget_stalls;     // had work but no budget at a boundary
+} seesaw_qos_stats_t;
+
+// Per-register timing. read_us: register select -> data ready, used when
+// a read's delay_us is 0. settle_us: how long the chip is busy after a
+// write; the next transaction to that address waits it out on a timer
+// rather than anyone sleeping.
+typedef struct {
+    uint8_t  module;
+    uint8_t  reg;
+    uint16_t read_us;
+    uint16_t settle_us;
+} seesaw_timing_t;
+
+#define SEESAW_TIMING_SLOTS  16
+
+// Adds or updates an entry; false if the table is full.
+bool seesaw_set_timing(uint8_t module, uint8_t reg, uint16_t read_us, uint16_t settle_us);
+const seesaw_timing_t *seesaw_timing(uint8_t module, uint8_t reg);     // NULL if absent
+
+// One transaction engine per I2C controller; both run at the same time.
+typedef struct seesaw_bus seesaw_bus_t;
+
+// Asynchronous transaction. The caller owns the descriptor and the buffers
+// it points at until done runs (in interrupt context) or busy drops.
+typedef struct seesaw_xfer seesaw_xfer_t;
+typedef void (*seesaw_done_fn)(seesaw_xfer_t *x);
+
+struct seesaw_xfer {
+    seesaw_bus_t *bus;          // NULL = the bus addr is assigned to
+    uint8_t  addr;
+    uint8_t  module;
+    uint8_t  reg;
+    bool     read;
+    uint8_t  prio;              // SEESAW_PRIO_*
+    const uint8_t *pre;         // write: sent between reg and out, e.g. a buffer offset
+    uint8_t  pre_len;
+    const uint8_t *out;         // write payload, not copied
+    uint8_t  *in;               // read destination
+    uint16_t len;
+    uint16_t delay_us;          // read: 0 = from the timing table
+    seesaw_done_fn done;
+    void     *user;
+    bool     no_retry;          // probes and measurements want the first answer
+
+    // engine state
+    volatile bool busy;
+    bool     ok;
+    seesaw_bus_t *on;           // bus it was queued on
+    uint8_t  attempts;
+    uint32_t first_us;          // first attempt's start
+    uint32_t submit_us;
+    uint32_t start_us;          // first byte on the bus; done - start = bus time
+    uint32_t latency_us;        // submit -> done
+    seesaw_xfer_t *next;
+};
+
+// Opens both buses at hz. Every address starts on bus 0.
 void seesaw_bus_init(uint32_t hz);
+uint32_t seesaw_transactions(void);     // all buses
+
+seesaw_bus_t *seesaw_bus(uint8_t num);  // NULL if not open
+uint8_t seesaw_bus_num(const seesaw_bus_t *bus);
+i2c_inst_t *seesaw_bus_i2c(const seesaw_bus_t *bus);
+uint32_t seesaw_bus_speed(const seesaw_bus_t *bus);
+uint32_t seesaw_bus_set_speed(seesaw_bus_t *bus, uint32_t hz);     // actual rate
+uint32_t seesaw_bus_faults(const seesaw_bus_t *bus);    // retries + failures + recoveries
+
+// Routes transactions for addr to bus from now on; may be changed at any
+// time, descriptors already queued finish where they are.
+void seesaw_bus_assign(uint8_t addr, seesaw_bus_t *bus);
+seesaw_bus_t *seesaw_bus_for(uint8_t addr);
+bool seesaw_probe(seesaw_bus_t *bus, uint8_t addr);
+
+// Clocks a stuck slave free and reinitializes the controller. The engine
+// does this by itself; exposed for boot code that finds a dead bus.
+void seesaw_bus_recover(seesaw_bus_t *bus);
+
+// Queues x and returns at once; false if x is still busy or malformed.
+bool seesaw_submit(seesaw_xfer_t *x);
+// Bytes x puts on the wire, address bytes included; what budgets and the
+// per-bus byte counters charge.
+uint32_t seesaw_xfer_cost(const seesaw_xfer_t *x);
+uint32_t seesaw_queue_depth(void);      // queued + running, all buses
+uint32_t seesaw_queue_depth_prio(uint8_t prio);     // queued only
+void seesaw_set_budget(uint8_t prio, uint8_t share_pct);     // each bus; 0 = unlimited
+const seesaw_qos_stats_t *seesaw_qos_stats(const seesaw_bus_t *bus, uint8_t prio);
+void seesaw_engine_print(void);
+
+// Blocking wrappers over the engine.
+bool seesaw_transfer(seesaw_xfer_t *x);     // submit and wait
 bool seesaw_write(uint8_t addr, uint8_t module, uint8_t reg,
                   const uint8_t *data, uint16_t len);
+bool seesaw_write_sg(uint8_t addr, uint8_t module, uint8_t reg,
+                     const uint8_t *pre, uint8_t pre_len,
+                     const uint8_t *data, uint16_t len);
 bool seesaw_read(uint8_t addr, uint8_t module, uint8_t reg,
                  uint8_t *data, uint16_t len);
+// Single attempt at an explicit delay, for timing measurements.
+bool seesaw_read_delay(uint8_t addr, uint8_t module, uint8_t reg,
+                       uint8_t *data, uint16_t len, uint16_t delay_us);
 
                  bool seesaw_write_buf(uint8_t addr, uint8_t module, uint8_t reg,
                   const uint8_t *data, size_t len);
@@ -0,0 +1,48 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+// 16-step sequencer. Steps are 16th notes and are clocked from a hardware
+// alarm, so tempo does not depend on how long the main loop takes.
+#define SEQ_STEPS       16
+#define SEQ_TRACKS      4
+#define SEQ_PATTERNS    8
+#define SEQ_CHAIN_MAX   16
+#define SEQ_TAG_BASE    0x40        // audio_note_on tags, one per track
+
+#define SEQ_BPM_MIN     40
+#define SEQ_BPM_MAX     300
+
+// One bit per step per track: a whole pattern is 8 bytes.
+typedef struct {
+    uint16_t steps[SEQ_TRACKS];
+} seq_pattern_t;
+
+void seq_init(void);
+void seq_start(void);
+void seq_stop(void);
+bool seq_running(void);
+
+void     seq_set_bpm(uint16_t bpm);
+uint16_t seq_bpm(void);
+
+// Editing works on the selected track of the selected pattern.
+void seq_select_track(int track);
+void seq_select_pattern(int pattern);
+int  seq_track(void);
+int  seq_pattern(void);
+void seq_toggle_step(int step);
+void seq_set_track_key(int track, int key);     // tuning table index it plays
+
+// Chained patterns play back to back; an empty chain loops the selected one.
+bool seq_chain_append(int pattern);
+void seq_chain_clear(void);
+
+// Key handler for sequencer mode: a key toggles the step under it.
+void seq_key(int idx, bool pressed);
+
+// Main-loop side. seq_update_leds moves the playhead with two pixel
+// writes and one SHOW; seq_redraw repaints the whole grid.
+void seq_update_leds(void);
+void seq_redraw(void);
+void seq_print(void);
@@ -0,0 +1,62 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Standard MIDI File (format 0/1) reader. It walks the file in place
+// (e.g. straight out of XIP flash) and never copies track data. Tracks
+// are merged in time order with a small min-heap keyed on the next tick.
+// No SDK dependencies, so it builds on a host as-is.
+#define SMF_MAX_TRACKS      16
+
+typedef struct {
+    const uint8_t *pos;         // next event (after its delta time)
+    const uint8_t *end;
+    uint32_t tick;              // absolute tick of the event at pos
+    uint8_t running;            // running status
+} smf_track_t;
+
+typedef struct {
+    uint32_t tick;
+    uint32_t time_us;           // from the start of the song, tempo map applied
+    uint8_t  track;
+    uint8_t  status;            // 0x80..0xEF channel message, 0xFF meta, 0xF0/0xF7 sysex
+    uint8_t  d1, d2;            // channel message data, or meta type in d1
+    const uint8_t *data;        // meta/sysex payload, points into the file
+    uint32_t len;
+} smf_event_t;
+
+typedef struct {
+    const uint8_t *data;
+    size_t len;
+    uint16_t format;
+    uint16_t ntracks;
+    uint16_t division;          // ticks per quarter note
+
+    smf_track_t tracks[SMF_MAX_TRACKS];
+    uint8_t heap[SMF_MAX_TRACKS];
+    uint8_t heap_n;
+
+    uint32_t tempo;             // us per quarter note
+    uint32_t tempo_tick;        // tick of the last tempo change
+    uint64_t tempo_us;          // time of the last tempo change
+} smf_file_t;
+
+typedef enum {
+    SMF_OK = 0,
+    SMF_ERR_HEADER,
+    SMF_ERR_FORMAT,             // format 2 or SMPTE timing
+    SMF_ERR_TRUNCATED,
+} smf_err_t;
+
+smf_err_t smf_open(smf_file_t *f, const uint8_t *data, size_t len);
+
+// Next event across all tracks in time order. false at the end of the song.
+bool smf_next(smf_file_t *f, smf_event_t *ev);
+
+static inline bool smf_is_note_on(const smf_event_t *ev) {
+    return (ev->status & 0xF0) == 0x90 && ev->d2 != 0;
+}
+static inline bool smf_is_note_off(const smf_event_t *ev) {
+    return (ev->status & 0xF0) == 0x80 || ((ev->status & 0xF0) == 0x90 && ev->d2 == 0);
+}
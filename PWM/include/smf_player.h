@@ -0,0 +1,23 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+// Plays Standard MIDI Files embedded in flash through the synth. Events
+// are dispatched from a hardware alarm, so playback is a repeatable load
+// on the audio path regardless of what the main loop is doing.
+#define SMF_TAG_BASE    0x180       // audio tags: 0x180 | note, apart from MIDI_TAG
+
+typedef struct {
+    const char    *name;
+    const uint8_t *data;
+    uint32_t       len;
+} smf_song_t;
+
+extern const smf_song_t smf_songs[];
+extern const int smf_song_count;
+
+bool smf_player_start(int song, bool loop);
+void smf_player_stop(void);
+bool smf_player_playing(void);
+int  smf_player_song(void);
+void smf_player_print(void);
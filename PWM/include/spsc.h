@@ -0,0 +1,67 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "hardware/sync.h"
+
+// Single-producer, single-consumer ring of fixed-size elements. The
+// producer only writes head, the consumer only tail, so push and pop need
+// no lock between a thread and an IRQ or between the two cores. Indices run
+// freely and are masked on access, so the size must be a power of two.
+// head and tail sit in separate 32-byte lines, which keeps the two sides
+// from writing the same line of SRAM.
+#define SPSC_LINE   32
+
+typedef struct spsc {
+    volatile uint32_t head __attribute__((aligned(SPSC_LINE)));
+    uint32_t hwm;               // most elements ever queued, producer side
+    uint32_t dropped;           // pushes refused because the ring was full
+    volatile uint32_t tail __attribute__((aligned(SPSC_LINE)));
+    uint8_t  *slots;
+    uint16_t mask;
+    uint16_t elem;
+} spsc_t;
+
+// Static ring called name holding size elements of type.
+#define SPSC_DEFINE(name, type, size)                                              \
+    _Static_assert(((size) & ((size) - 1)) == 0, #name " size must be a power of two"); \
+    static type name##_slots[size] __attribute__((aligned(SPSC_LINE)));            \
+    static spsc_t name = { .slots = (uint8_t *)name##_slots, .mask = (size) - 1, .elem = sizeof(type) }
+
+static inline uint32_t spsc_count(const spsc_t *q)
+{
+    return q->head - q->tail;
+}
+
+// Producer only. False, and counted as dropped, if the ring is full.
+static inline bool spsc_push(spsc_t *q, const void *e)
+{
+    uint32_t head = q->head;
+    uint32_t used = head - q->tail;
+
+    if (used > q->mask) {
+        q->dropped++;
+        return false;
+    }
+    memcpy(q->slots + (head & q->mask) * q->elem, e, q->elem);
+    if (used + 1 > q->hwm) q->hwm = used + 1;
+    __dmb();            // slot contents visible before the new head
+    q->head = head + 1;
+    return true;
+}
+
+// Consumer only. False if the ring is empty.
+static inline bool spsc_pop(spsc_t *q, void *e)
+{
+    uint32_t tail = q->tail;
+
+    if (tail == q->head) return false;
+    __dmb();            // slot read after the head that published it
+    memcpy(e, q->slots + (tail & q->mask) * q->elem, q->elem);
+    __dmb();            // slot read before it is handed back
+    q->tail = tail + 1;
+    return true;
+}
+
+// Depth, high-water mark and drops on one line.
+void spsc_print(const char *name, const spsc_t *q);
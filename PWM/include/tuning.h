@@ -0,0 +1,57 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "pitch.h"
+
+#define TUNING_KEYS         16
+#define TUNING_USER_MAX     12
+
+typedef enum {
+    SCALE_MAJOR,
+    SCALE_MINOR,
+    SCALE_CHROMATIC,
+    SCALE_PENTATONIC,
+    SCALE_USER,
+    SCALE_COUNT
+} scale_t;
+
+typedef enum {
+    TEMPER_EQUAL,
+    TEMPER_JUST,            // 5-limit just intonation on the root
+    TEMPER_PYTHAGOREAN,
+    TEMPER_MEANTONE,        // quarter-comma
+    TEMPER_COUNT
+} temperament_t;
+
+// Everything a key press needs, worked out once when the tuning changes.
+typedef struct {
+    int32_t  pitch;         // PITCH_* units, temperament applied
+    uint32_t inc;           // oscillator phase increment at that pitch
+    uint16_t hz;            // rounded, for display
+    uint8_t  note;          // MIDI note number
+    char     name[5];       // e.g. "C#4"
+} tuning_key_t;
+
+extern tuning_key_t tuning_table[TUNING_KEYS];
+
+// Hot path: one indexed load, no math.
+static inline const tuning_key_t *tuning_key(int idx) {
+    return &tuning_table[idx];
+}
+
+// Each setter rebuilds tuning_table once. Defaults: C major from C4, equal.
+void tuning_init(void);
+void tuning_set_scale(scale_t scale);
+void tuning_set_root(uint8_t semitone);         // 0 = C .. 11 = B
+void tuning_set_octave(int8_t shift);           // -3 .. +3 around octave 4
+void tuning_set_temperament(temperament_t t);
+bool tuning_set_user_scale(const uint8_t *steps, uint8_t n);
+
+scale_t       tuning_scale(void);
+uint8_t       tuning_root(void);
+int8_t        tuning_octave(void);
+temperament_t tuning_temperament(void);
+
+const char *tuning_scale_name(scale_t scale);
+const char *tuning_temperament_name(temperament_t t);
+void tuning_print(void);
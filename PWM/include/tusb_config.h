@@ -0,0 +1,29 @@
+#pragma once
+
+// TinyUSB device configuration: CDC (stdio) + MIDI composite. Having our
+// own config and descriptors means the SDK's stdio_usb only drives the CDC
+// interface and leaves tusb_init()/tud_task() to usb_midi.c.
+
+#ifndef CFG_TUSB_RHPORT0_MODE
+#define CFG_TUSB_RHPORT0_MODE   OPT_MODE_DEVICE
+#endif
+
+#ifndef CFG_TUSB_OS
+#define CFG_TUSB_OS             OPT_OS_PICO
+#endif
+
+#define CFG_TUD_ENABLED         1
+#define CFG_TUD_ENDPOINT0_SIZE  64
+
+#define CFG_TUD_CDC             1
+#define CFG_TUD_MIDI            1
+#define CFG_TUD_MSC             0
+#define CFG_TUD_HID             0
+#define CFG_TUD_VENDOR          0
+
+#define CFG_TUD_CDC_RX_BUFSIZE  256
+#define CFG_TUD_CDC_TX_BUFSIZE  256
+#define CFG_TUD_CDC_EP_BUFSIZE  64
+
+#define CFG_TUD_MIDI_RX_BUFSIZE 64
+#define CFG_TUD_MIDI_TX_BUFSIZE 64
@@ -0,0 +1,34 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "midi.h"
+
+// DIN MIDI (31250 baud) on uart1; uart0 on GPIO 0/1 stays the stdio UART.
+// RX: DMA writes into a byte ring forever and a timer publishes what has
+// arrived once the line has been quiet for UART_MIDI_IDLE_US, so there is
+// no per-byte interrupt. The timer runs only from a start bit on a quiet
+// line until the line is quiet again. TX: messages are packed with running status into
+// a buffer that goes out as one DMA transfer.
+#define UART_MIDI_ID        uart1
+#define UART_MIDI_TX_PIN    8
+#define UART_MIDI_RX_PIN    9
+#define UART_MIDI_BAUD      31250
+#define UART_MIDI_IDLE_US   640         // two byte times
+
+void uart_midi_init(void);
+
+// Parses published RX bytes in place and starts the next TX batch. Call
+// from the main loop.
+void uart_midi_task(void);
+
+// Queue a message for the next TX batch; false if the batch is full.
+bool uart_midi_send(const midi_msg_t *m);
+
+// Note off goes out as note on with velocity 0 so it shares running status.
+void uart_midi_send_note(uint8_t note, uint8_t velocity, bool on);
+
+// With TX jumpered to RX: sends a short phrase and checks that it parses
+// back unchanged. Blocks for at most ~50 ms.
+void uart_midi_loopback_test(void);
+
+void uart_midi_print(void);
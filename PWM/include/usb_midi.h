@@ -0,0 +1,19 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+// USB-MIDI next to the CDC serial console. Incoming notes are posted to the
+// renderer through its lock-free queue; outgoing notes go straight into the
+// TinyUSB FIFO. Nothing here blocks or disables interrupts.
+
+// Call before stdio_init_all(): brings up the composite device.
+void usb_midi_init(void);
+
+// Services the USB stack and drains received packets. Call from the main loop.
+void usb_midi_task(void);
+
+// Sends note on/off on MIDI_CHANNEL; dropped (and counted) if the host is
+// not listening or the FIFO is full.
+void usb_midi_send_note(uint8_t note, uint8_t velocity, bool on);
+
+void usb_midi_print(void);
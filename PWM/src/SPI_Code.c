@@ -2,6 +2,9 @@
 #include "pico/stdlib.h"
 #include "hardware/spi.h"
 #include "lcd.h"
+#include "tuning.h"
+#include "neotrellis.h"
+#include "cores.h"
 
 
 #include <stdio.h>
@@ -44,105 +47,74 @@ void init_spi_lcd() {
     spi_set_format(spi0, 8, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
 }
 
-// call next two in main
-
+// Runs on core 1 at boot (cores_init); stdio is core 0's.
 void LCD_start() {
-    stdio_init_all();
-
     init_spi_lcd();
 
     LCD_Setup();
     LCD_Clear(BLACK); // Clear the screen to black
 }
 
+// Background color per key; the note text comes from the tuning table
+static const u16 note_colors[16] = {
+    RED, GREEN, BLUE, YELLOW, MAGENTA, CYAN, LBBLUE, BROWN,
+    GREEN, GBLUE, BRRED, MAGENTA, YELLOW, BRRED, LBBLUE, MAGENTA
+};
+
 void LCD_note(int n)
 {
-    switch (n){
-        case 0:
-            LCD_Clear(RED); // Clear the screen to black
-            LCD_DrawString(0, 0, BLACK, RED, "Note: C4", 16, 0);
-            LCD_DrawString(0, 20, BLACK, RED, "Frequency: 262", 16, 0);
-            break;
-        case 1:
-            LCD_Clear(GREEN); // Clear the screen to black
-            LCD_DrawString(0, 0, BLACK, GREEN, "Note: D4", 16, 0);
-            LCD_DrawString(0, 20, BLACK, GREEN, "Frequency: 294", 16, 0);
-            break;
-        case 2:
-            LCD_Clear(BLUE); // Clear the screen to black
-            LCD_DrawString(0, 0, BLACK, BLUE, "Note: E4", 16, 0);
-            LCD_DrawString(0, 20, BLACK, BLUE, "Frequency: 330", 16, 0);
-            break;
-        case 3:
-            LCD_Clear(YELLOW); // Clear the screen to black
-            LCD_DrawString(0, 0, BLACK, YELLOW, "Note: F4", 16, 0);
-            LCD_DrawString(0, 20, BLACK, YELLOW, "Frequency: 349", 16, 0);
-            break;
-        case 4:
-            LCD_Clear(MAGENTA); // Clear the screen to black
-            LCD_DrawString(0, 0, BLACK, MAGENTA, "Note: G4", 16, 0);
-            LCD_DrawString(0, 20, BLACK, MAGENTA, "Frequency: 392", 16, 0);
-            break;
-        case 5:
-            LCD_Clear(CYAN); // Clear the screen to black
-            LCD_DrawString(0, 0, BLACK, CYAN, "Note: A4", 16, 0);
-            LCD_DrawString(0, 20, BLACK, CYAN, "Frequency: 440", 16, 0);
-            break;
-        case 6:
-            LCD_Clear(LBBLUE); // Clear the screen to black
-            LCD_DrawString(0, 0, BLACK, LBBLUE, "Note: B4", 16, 0);
-            LCD_DrawString(0, 20, BLACK, LBBLUE, "Frequency: 494", 16, 0);
-            break;
-        case 7:
-            LCD_Clear(BROWN); // Clear the screen to black
-            LCD_DrawString(0, 0, BLACK, BROWN, "Note: C5", 16, 0);
-            LCD_DrawString(0, 20, BLACK, BROWN, "Frequency: 523", 16, 0);
-            break;
-        case 8:
-            LCD_Clear(GREEN); // Clear the screen to black
-            LCD_DrawString(0, 0, BLACK, GREEN, "Note: D5", 16, 0);
-            LCD_DrawString(0, 20, BLACK, GREEN, "Frequency: 587", 16, 0);
-            break;
-        case 9:
-            LCD_Clear(GBLUE); // Clear the screen to black
-            LCD_DrawString(0, 0, BLACK, GBLUE, "Note: E5", 16, 0);
-            LCD_DrawString(0, 20, BLACK, GBLUE, "Frequency: 659", 16, 0);
-            break;
-        case 10:
-            LCD_Clear(BRRED); // Clear the screen to black
-            LCD_DrawString(0, 0, BLACK, BRRED, "Note: F5", 16, 0);
-            LCD_DrawString(0, 20, BLACK, BRRED, "Frequency: 698", 16, 0);
-            break;
-        case 11:
-            LCD_Clear(MAGENTA); // Clear the screen to black
-            LCD_DrawString(0, 0, BLACK, MAGENTA, "Note: G5", 16, 0);
-            LCD_DrawString(0, 20, BLACK, MAGENTA, "Frequency: 784", 16, 0);
-            break;
-        case 12:
-            LCD_Clear(YELLOW); // Clear the screen to black
-            LCD_DrawString(0, 0, BLACK, YELLOW, "Note: A5", 16, 0);
-            LCD_DrawString(0, 20, BLACK, YELLOW, "Frequency: 880", 16, 0);
-            break;
-        case 13:
-            LCD_Clear(BRRED); // Clear the screen to black
-            LCD_DrawString(0, 0, BLACK, BRRED, "Note: B5", 16, 0);
-            LCD_DrawString(0, 20, BLACK, BRRED, "Frequency: 988", 16, 0);
-            break;
-        case 14:
-            LCD_Clear(LBBLUE); // Clear the screen to black
-            LCD_DrawString(0, 0, BLACK, LBBLUE, "Note: C6", 16, 0);
-            LCD_DrawString(0, 20, BLACK, LBBLUE, "Frequency: 1047", 16, 0);
-            break;
-        case 15:
-            LCD_Clear(MAGENTA); // Clear the screen to black
-            LCD_DrawString(0, 0, BLACK, MAGENTA, "Note: D6", 16, 0);
-            LCD_DrawString(0, 20, BLACK, MAGENTA, "Frequency: 1175", 16, 0);
-            break;
-        default: LCD_Clear(BLACK);
+    if (n < 0 || n >= TUNING_KEYS) {
+        LCD_Clear(BLACK);
+        return;
+    }
+
+    const tuning_key_t *k = tuning_key(n);
+    u16 bg = note_colors[n];
+    char line[24];
+
+    LCD_Clear(bg);
+    snprintf(line, sizeof line, "Note: %s", k->name);
+    LCD_DrawString(0, 0, BLACK, bg, line, 16, 0);
+    snprintf(line, sizeof line, "Frequency: %u", k->hz);
+    LCD_DrawString(0, 20, BLACK, bg, line, 16, 0);
+}
+
 
+// Key edges for the screen. A full-screen redraw takes tens of ms, so the
+// task drains everything queued and draws only the latest state.
+#define LCD_KEYQ_SIZE   16
+SPSC_DEFINE(lcd_keyq, neotrellis_event_t, LCD_KEYQ_SIZE);
+
+bool LCD_post_key(int key, bool pressed)
+{
+    neotrellis_event_t ev = { .key = (uint8_t)key, .pressed = pressed, .time_us = time_us_32() };
+    bool ok = spsc_push(&lcd_keyq, &ev);
+    __sev();            // core 1 waits in WFE
+    return ok;
+}
+
+void LCD_task(void)
+{
+    neotrellis_event_t ev;
+    bool redraw = false;
+    int show = -1;
+
+    while (spsc_pop(&lcd_keyq, &ev)) {
+        cores_log("[neo] Button %d %s\n", ev.key, ev.pressed ? "PRESSED" : "RELEASED");
+        if (ev.pressed && ev.key < TUNING_KEYS) {
+            const tuning_key_t *k = tuning_key(ev.key);
+            cores_log("PLAYING: %s (%u Hz)\n", k->name, k->hz);
+        }
+        show = ev.pressed ? ev.key : -1;
+        redraw = true;
     }
+    if (redraw && cores_lcd_ready()) LCD_note(show);
 }
 
+const spsc_t *LCD_key_queue(void)
+{
+    return &lcd_keyq;
+}
 
 /* SD Card Setup and functions */
 
@@ -185,7 +157,5 @@ void init_sdcard_io() {
     disable_sdcard();
 }
 
-void init_uart();
-void init_uart_irq();
 void date(int argc, char *argv[]);
 void command_shell();
@@ -0,0 +1,338 @@
+#include "anim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "neotrellis.h"
+#include "seesaw.h"
+#include "pitch.h"
+#include "cores.h"
+
+#define GRID_W          NEOTRELLIS_GRID_W
+#define GRID_H          NEOTRELLIS_GRID_H
+#define KEYS            NEOTRELLIS_LED_COUNT
+
+#define FADE_SHIFT      3               // release trail loses 1/8 per frame
+#define PULSE_INC       (0xFFFFFFFFu / ANIM_FPS)    // 1 Hz breathing
+#define RIPPLE_SPEED    5               // Q4 pixels per frame
+#define RIPPLE_WIDTH    16              // Q4: one pixel either side of the ring
+#define RIPPLE_DECAY    6               // amplitude lost per frame, of 255
+
+typedef enum { FX_NONE, FX_PULSE, FX_FADE } fx_t;
+
+typedef struct {
+    uint8_t  fx;
+    uint8_t  level;                     // 0..255
+    uint32_t phase;
+} key_fx_t;
+
+typedef struct {
+    uint8_t  origin;
+    uint8_t  amp;                       // 0 = free slot
+    uint16_t radius;                    // Q4 pixels
+} ripple_t;
+
+// 2.2 gamma, so fades look linear to the eye
+static const uint8_t gamma8[256] = {
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,
+      3,   3,   3,   3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   6,   6,   6,
+      6,   7,   7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  11,  11,  11,  12,
+     12,  13,  13,  13,  14,  14,  15,  15,  16,  16,  17,  17,  18,  18,  19,  19,
+     20,  20,  21,  22,  22,  23,  23,  24,  25,  25,  26,  26,  27,  28,  28,  29,
+     30,  30,  31,  32,  33,  33,  34,  35,  35,  36,  37,  38,  39,  39,  40,  41,
+     42,  43,  43,  44,  45,  46,  47,  48,  49,  49,  50,  51,  52,  53,  54,  55,
+     56,  57,  58,  59,  60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  70,  71,
+     73,  74,  75,  76,  77,  78,  79,  81,  82,  83,  84,  85,  87,  88,  89,  90,
+     91,  93,  94,  95,  97,  98,  99, 100, 102, 103, 105, 106, 107, 109, 110, 111,
+    113, 114, 116, 117, 119, 120, 121, 123, 124, 126, 127, 129, 130, 132, 133, 135,
+    137, 138, 140, 141, 143, 145, 146, 148, 149, 151, 153, 154, 156, 158, 159, 161,
+    163, 165, 166, 168, 170, 172, 173, 175, 177, 179, 181, 182, 184, 186, 188, 190,
+    192, 194, 196, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221,
+    223, 225, 227, 229, 231, 234, 236, 238, 240, 242, 244, 246, 248, 251, 253, 255,
+};
+
+static uint8_t wheel[256][3];           // RGB
+static uint16_t dist[GRID_H][GRID_W];   // Q4 pixels, by |dy|, |dx|
+
+static key_fx_t keys[KEYS];
+static ripple_t ripples[ANIM_RIPPLES];
+static uint16_t rainbow_left = 0;
+static uint16_t rainbow_len = 1;
+
+// What the current frame draws, copied out under the lock (core 1 only)
+static key_fx_t frame_keys[KEYS];
+static ripple_t frame_ripples[ANIM_RIPPLES];
+static uint16_t frame_rainbow_left;
+static uint16_t frame_rainbow_len;
+
+static volatile bool enabled = false;
+static volatile bool rendering = false;
+static uint16_t brightness = 128;
+static uint32_t frame = 0;
+static uint32_t flushed = 0;
+static uint32_t skipped = 0;
+static uint32_t render_us_max = 0;
+
+#define KEYQ_SIZE   32
+SPSC_DEFINE(keyq, neotrellis_event_t, KEYQ_SIZE);
+
+static void color_wheel(uint8_t pos, uint8_t *r, uint8_t *g, uint8_t *b) {
+    if (pos < 85) {
+        *r = 255 - pos * 3;
+        *g = pos * 3;
+        *b = 0;
+    } else if (pos < 170) {
+        pos -= 85;
+        *r = 0;
+        *g = 255 - pos * 3;
+        *b = pos * 3;
+    } else {
+        pos -= 170;
+        *r = pos * 3;
+        *g = 0;
+        *b = 255 - pos * 3;
+    }
+}
+
+static uint32_t isqrt(uint32_t v)
+{
+    uint32_t r = 0, bit = 1u << 30;
+    while (bit > v) bit >>= 2;
+    while (bit) {
+        if (v >= r + bit) {
+            v -= r + bit;
+            r = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+        bit >>= 2;
+    }
+    return r;
+}
+
+static inline void add_rgb(uint16_t *acc, const uint8_t *c, uint32_t level)
+{
+    acc[0] = (uint16_t)(acc[0] + ((c[0] * level) >> 8));
+    acc[1] = (uint16_t)(acc[1] + ((c[1] * level) >> 8));
+    acc[2] = (uint16_t)(acc[2] + ((c[2] * level) >> 8));
+}
+
+static inline const uint8_t *key_color(int k)
+{
+    return wheel[(k * 16) & 0xFF];
+}
+
+// Under the anim lock: copies out what this frame draws and moves the
+// shared effects on by a frame. This is the only part core 0 can wait on.
+static void step(void)
+{
+    for (int k = 0; k < KEYS; k++) {
+        key_fx_t *f = &keys[k];
+        if (f->fx == FX_PULSE) f->phase += PULSE_INC;
+        frame_keys[k] = *f;
+        if (f->fx == FX_FADE) {
+            f->level = (uint8_t)(f->level - (f->level >> FADE_SHIFT) - 1);
+            if (f->level < 4) f->fx = FX_NONE;
+        }
+    }
+
+    for (int i = 0; i < ANIM_RIPPLES; i++) {
+        ripple_t *rp = &ripples[i];
+        frame_ripples[i] = *rp;
+        if (!rp->amp) continue;
+        rp->radius += RIPPLE_SPEED;
+        rp->amp = rp->amp > RIPPLE_DECAY ? (uint8_t)(rp->amp - RIPPLE_DECAY) : 0;
+    }
+
+    frame_rainbow_left = rainbow_left;
+    frame_rainbow_len = rainbow_len;
+    if (rainbow_left) rainbow_left--;
+}
+
+// Draws the copied frame into the framebuffer, without the lock.
+static void render(void)
+{
+    for (int k = 0; k < KEYS; k++) {
+        uint16_t acc[3] = { 0, 0, 0 };
+        const key_fx_t *f = &frame_keys[k];
+
+        if (f->fx == FX_PULSE) {
+            // 75% .. 100%
+            uint32_t level = 224 + ((pitch_lfo_sine(f->phase) * 31) >> 15);
+            add_rgb(acc, key_color(k), level);
+        } else if (f->fx == FX_FADE) {
+            add_rgb(acc, key_color(k), f->level);
+        }
+
+        for (int i = 0; i < ANIM_RIPPLES; i++) {
+            const ripple_t *rp = &frame_ripples[i];
+            if (!rp->amp) continue;
+            int dx = abs(rp->origin % GRID_W - k % GRID_W);
+            int dy = abs(rp->origin / GRID_W - k / GRID_W);
+            int d = (int)dist[dy][dx] - (int)rp->radius;
+            if (d < 0) d = -d;
+            if (d >= RIPPLE_WIDTH) continue;
+            uint32_t level = (uint32_t)(RIPPLE_WIDTH - d) * rp->amp / RIPPLE_WIDTH;
+            add_rgb(acc, key_color(rp->origin), level);
+        }
+
+        if (frame_rainbow_left) {
+            uint32_t level = 256;
+            if (frame_rainbow_left < 16) level = frame_rainbow_left * 16u;
+            add_rgb(acc, wheel[(k * 16 + (frame_rainbow_len - frame_rainbow_left) * 8) & 0xFF], level);
+        }
+
+        uint8_t out[3];
+        for (int c = 0; c < 3; c++) {
+            uint32_t v = acc[c] > 255 ? 255 : acc[c];
+            out[c] = gamma8[(v * brightness) >> 8];
+        }
+        neopixel_set_pixel(k, out[0], out[1], out[2]);
+    }
+}
+
+static void apply_key(int idx, bool pressed);
+
+// Runs on core 1. The effect state is shared with anim_key and friends on
+// core 0, some of them in IRQs, so the frame holds the anim spinlock only
+// to step it and renders from its own copy. rendering lets anim_enable
+// wait out a frame that is still drawing.
+static int64_t anim_tick(alarm_id_t id, void *user)
+{
+    neotrellis_event_t ev;
+    spin_lock_t *lock = cores_lock(CORES_LOCK_ANIM);
+
+    frame++;
+    uint32_t t0 = time_us_32();
+    uint32_t irq = spin_lock_blocking(lock);
+    while (spsc_pop(&keyq, &ev)) {
+        if (enabled) apply_key(ev.key, ev.pressed);
+    }
+    if (enabled) {
+        step();
+        rendering = true;
+    }
+    spin_unlock(lock, irq);
+    if (!rendering) return -ANIM_FRAME_US;
+
+    render();
+    __dmb();                    // pixels written before the flag drops
+    rendering = false;
+
+    uint32_t dt = time_us_32() - t0;
+    if (dt > render_us_max) render_us_max = dt;
+    cores_load_add(CORES_LOAD_ANIM, dt);
+
+    // The engine meters LED traffic against its budget and always lets
+    // keypad reads go first. While a frame is still on its way the flush
+    // only flags itself; the framebuffer keeps the changes dirty. The
+    // flush itself runs on core 0, which owns the engine.
+    if (seesaw_queue_depth_prio(SEESAW_PRIO_LED) == 0 && cores_send(CORES_MSG_LED_SHOW)) {
+        flushed++;
+    } else {
+        skipped++;
+    }
+    return -ANIM_FRAME_US;
+}
+
+void anim_init(void)
+{
+    for (int i = 0; i < 256; i++) color_wheel((uint8_t)i, &wheel[i][0], &wheel[i][1], &wheel[i][2]);
+
+    for (int dy = 0; dy < GRID_H; dy++) {
+        for (int dx = 0; dx < GRID_W; dx++) {
+            dist[dy][dx] = (uint16_t)isqrt((uint32_t)(dx * dx + dy * dy) << 8);
+        }
+    }
+
+    alarm_pool_add_alarm_in_us(cores_ui_pool(), ANIM_FRAME_US, anim_tick, NULL, true);
+}
+
+static void clear_effects(void)
+{
+    for (int k = 0; k < KEYS; k++) keys[k].fx = FX_NONE;
+    for (int i = 0; i < ANIM_RIPPLES; i++) ripples[i].amp = 0;
+    rainbow_left = 0;
+}
+
+void anim_enable(bool on)
+{
+    spin_lock_t *lock = cores_lock(CORES_LOCK_ANIM);
+    uint32_t irq = spin_lock_blocking(lock);
+    clear_effects();
+    enabled = on;
+    spin_unlock(lock, irq);
+
+    // A frame already stepped would otherwise land on whatever paints next
+    while (rendering) tight_loop_contents();
+}
+
+bool anim_enabled(void)
+{
+    return enabled;
+}
+
+static void apply_key(int idx, bool pressed)
+{
+    key_fx_t *f = &keys[idx];
+    if (pressed) {
+        f->fx = FX_PULSE;
+        f->phase = 0x40000000u;         // start at the top of the breath
+
+        ripple_t *slot = &ripples[0];
+        for (int i = 0; i < ANIM_RIPPLES; i++) {
+            if (ripples[i].amp < slot->amp) slot = &ripples[i];
+        }
+        slot->origin = (uint8_t)idx;
+        slot->radius = 0;
+        slot->amp = 160;
+    } else {
+        f->fx = FX_FADE;
+        f->level = 255;
+    }
+}
+
+void anim_key(int idx, bool pressed)
+{
+    if ((unsigned)idx >= KEYS) return;
+
+    spin_lock_t *lock = cores_lock(CORES_LOCK_ANIM);
+    uint32_t irq = spin_lock_blocking(lock);
+    apply_key(idx, pressed);
+    spin_unlock(lock, irq);
+}
+
+bool anim_post_key(int idx, bool pressed)
+{
+    if ((unsigned)idx >= KEYS) return false;
+
+    neotrellis_event_t ev = { .key = (uint8_t)idx, .pressed = pressed, .time_us = time_us_32() };
+    return spsc_push(&keyq, &ev);
+}
+
+const spsc_t *anim_key_queue(void)
+{
+    return &keyq;
+}
+
+void anim_rainbow(uint16_t frames)
+{
+    spin_lock_t *lock = cores_lock(CORES_LOCK_ANIM);
+    uint32_t irq = spin_lock_blocking(lock);
+    rainbow_len = frames ? frames : 1;
+    rainbow_left = frames;
+    spin_unlock(lock, irq);
+}
+
+void anim_set_brightness(uint16_t q8)
+{
+    brightness = q8 > 256 ? 256 : q8;
+}
+
+void anim_print(void)
+{
+    printf("[ANIM] %s, %u fps, frame %lu: %lu flushed, %lu skipped for bus, render max %lu us\n",
+           enabled ? "on" : "off", ANIM_FPS, (unsigned long)frame,
+           (unsigned long)flushed, (unsigned long)skipped, (unsigned long)render_us_max);
+}
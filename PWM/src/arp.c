@@ -0,0 +1,206 @@
+#include "arp.h"
+#include "seq.h"
+#include "audio.h"
+#include "tuning.h"
+#include "neotrellis.h"
+#include "pico/stdlib.h"
+#include <stdio.h>
+
+#define ARP_GATE_MIN_US     500
+
+static const char *mode_names[ARP_MODE_COUNT] = { "up", "down", "up-down", "random" };
+static const char *rate_names[ARP_RATE_COUNT] = { "1/4", "1/8", "1/8T", "1/16", "1/16T", "1/32" };
+static const uint8_t rate_per_beat[ARP_RATE_COUNT] = { 1, 2, 3, 4, 6, 8 };
+
+static volatile uint16_t chord = 0;     // keys the arp plays, bit n = key n
+static uint16_t physical = 0;           // keys actually held right now
+static uint16_t shown = 0;              // chord as currently painted
+
+static arp_mode_t mode = ARP_UP;
+static arp_rate_t rate = ARP_RATE_16;
+static bool latch = false;
+static volatile uint16_t gate_q8 = 128;
+static volatile uint16_t swing_q8 = 0;
+
+// Alarm-side state
+static volatile bool running = false;
+static alarm_id_t alarm_id = 0;
+static uint64_t target_us;              // when the current callback was due
+static uint64_t step_start_us;
+static uint32_t step_index;
+static bool sounding = false;
+static int cur = -1;
+static bool going_up = true;
+static uint32_t rng = 0x2545F491;
+
+static uint32_t step_us(void)
+{
+    return 60000000u / ((uint32_t)seq_bpm() * rate_per_beat[rate]);
+}
+
+// Odd steps are pushed late by swing_q8/256 of half a step.
+static uint32_t swing_us(uint32_t index, uint32_t len)
+{
+    return (index & 1) ? (len / 2) * swing_q8 / 256u : 0;
+}
+
+static uint32_t xorshift(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+// Next key from the held mask with bit scans instead of walking an array.
+static int next_key(uint16_t held)
+{
+    uint32_t above = (cur < 0) ? held : (held & ~((2u << cur) - 1u));
+    uint32_t below = (cur < 0) ? held : (held & ((1u << cur) - 1u));
+
+    switch (mode) {
+        case ARP_UP:
+            return __builtin_ctz(above ? above : held);
+        case ARP_DOWN:
+            return 31 - __builtin_clz(below ? below : held);
+        case ARP_UPDOWN:
+            if (going_up && !above) going_up = false;
+            else if (!going_up && !below) going_up = true;
+            if (going_up) return __builtin_ctz(above ? above : held);
+            return 31 - __builtin_clz(below ? below : held);
+        case ARP_RANDOM:
+        default: {
+            uint32_t m = held;
+            uint32_t n = xorshift() % (uint32_t)__builtin_popcount(m);
+            while (n--) m &= m - 1;         // drop the lowest set bit n times
+            return __builtin_ctz(m);
+        }
+    }
+}
+
+// Alternates between "step starts" (note on, if any keys) and "gate ends"
+// (note off). Every target is computed from the step grid, and returning
+// a negative delay re-arms relative to the previous target, so jitter in
+// servicing the alarm never accumulates.
+static int64_t arp_tick(alarm_id_t id, void *user)
+{
+    if (!running) return 0;
+
+    uint64_t now_target = target_us;
+    uint32_t len = step_us();
+
+    if (sounding) {
+        audio_note_off(ARP_TAG);
+        sounding = false;
+    } else {
+        uint16_t held = chord;
+        if (held) {
+            cur = next_key(held);
+            audio_note_on(ARP_TAG, tuning_key(cur)->pitch);
+            sounding = true;
+
+            // Gate, clipped so the note ends before the next (swung) step starts
+            uint32_t gate = len * gate_q8 / 256u;
+            uint64_t next_on = step_start_us + len + swing_us(step_index + 1, len);
+            uint64_t room = next_on > now_target ? next_on - now_target : 0;
+            if ((uint64_t)gate + ARP_GATE_MIN_US > room)
+                gate = room > 2 * ARP_GATE_MIN_US ? (uint32_t)room - ARP_GATE_MIN_US : ARP_GATE_MIN_US;
+            if (gate < ARP_GATE_MIN_US) gate = ARP_GATE_MIN_US;
+
+            target_us = now_target + gate;
+            return -(int64_t)gate;
+        }
+    }
+
+    step_start_us += len;
+    step_index++;
+    target_us = step_start_us + swing_us(step_index, len);
+    if (target_us <= now_target) target_us = now_target + 1;
+    return -(int64_t)(target_us - now_target);
+}
+
+void arp_start(void)
+{
+    if (running) return;
+    cur = -1;
+    going_up = true;
+    sounding = false;
+    step_index = 0;
+    step_start_us = time_us_64() + 1000;
+    target_us = step_start_us;
+    running = true;
+    alarm_id = add_alarm_at(from_us_since_boot(target_us), arp_tick, NULL, true);
+}
+
+void arp_stop(void)
+{
+    if (!running) return;
+    running = false;
+    cancel_alarm(alarm_id);
+    audio_note_off(ARP_TAG);
+    chord = 0;
+    physical = 0;
+    shown = 0;          // the mode switch blanks the grid
+}
+
+void arp_set_mode(arp_mode_t m)   { if (m < ARP_MODE_COUNT) mode = m; }
+void arp_set_rate(arp_rate_t r)   { if (r < ARP_RATE_COUNT) rate = r; }
+arp_mode_t arp_mode(void)         { return mode; }
+arp_rate_t arp_rate(void)         { return rate; }
+bool arp_latch(void)              { return latch; }
+
+void arp_set_latch(bool on)
+{
+    latch = on;
+    if (!latch) chord = physical;
+}
+
+void arp_set_gate(uint16_t g)
+{
+    gate_q8 = g > 256 ? 256 : g;
+}
+
+void arp_set_swing(uint16_t s)
+{
+    swing_q8 = s > 256 ? 256 : s;
+}
+
+void arp_key(int idx, bool pressed)
+{
+    if ((unsigned)idx >= TUNING_KEYS) return;     // extra tiles carry no notes
+
+    uint16_t bit = (uint16_t)(1u << idx);
+
+    if (pressed) {
+        // With latch on, the first key of a new hand replaces the old chord
+        if (latch && physical == 0) chord = 0;
+        physical |= bit;
+        chord |= bit;
+    } else {
+        physical &= (uint16_t)~bit;
+        if (!latch) chord &= (uint16_t)~bit;
+    }
+}
+
+void arp_update_leds(void)
+{
+    uint16_t now = chord;
+    uint16_t diff = now ^ shown;
+    if (!diff) return;
+
+    while (diff) {
+        int k = __builtin_ctz(diff);
+        diff &= diff - 1;
+        if (now & (1u << k)) neopixel_set_pixel(k, 0x00, 0x10, 0x20);
+        else                 neopixel_set_pixel(k, 0, 0, 0);
+    }
+    shown = now;
+    neopixel_show();
+}
+
+void arp_print(void)
+{
+    printf("[ARP] %s, %s at %u bpm, latch %s, gate %u%%, swing %u%%\n",
+           mode_names[mode], rate_names[rate], seq_bpm(), latch ? "on" : "off",
+           gate_q8 * 100u / 256u, 50u + swing_q8 * 25u / 256u);
+}
@@ -0,0 +1,280 @@
+#include "audio.h"
+#include "pico/stdlib.h"
+#include "hardware/pwm.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "cores.h"
+
+#define AUDIO_MID       ((AUDIO_PWM_TOP + 1) / 2)
+#define AUDIO_AMPL      (AUDIO_MID - 1)
+
+typedef struct {
+    uint32_t phase;
+    uint32_t inc;           // increment of the last sample rendered
+    int32_t  pitch;         // current pitch, walks toward target while gliding
+    int32_t  target;
+    int32_t  glide_step;    // pitch units per block, 0 = settled
+    uint32_t age;           // stamped on every on/off, for voice allocation
+    uint16_t tag;
+    bool     gate;
+    bool     used;          // has a previous pitch to glide from
+} voice_t;
+
+static uint slice_num;
+static uint cc_shift;               // compare level lives in the top half for channel B
+static int dma_chan[2];
+static uint32_t audio_buf[2][AUDIO_BLOCK];
+static int32_t mix[AUDIO_BLOCK];
+
+static voice_t voices[AUDIO_VOICES];
+static uint32_t voice_clock = 0;
+
+static volatile uint32_t glide_blocks = 0;
+static volatile uint32_t lfo_inc = 0;
+static volatile int32_t lfo_depth = 0;
+static volatile int32_t bend = 0;
+static uint32_t lfo_phase = 0;
+static volatile int32_t pitch_mod = 0;    // bend + vibrato of the last block
+
+static volatile int32_t gain_target = 0;
+static int32_t gain = 0;
+
+// Notes posted from the main loop (keys, USB, UART), drained by the
+// renderer at the top of each block.
+#define AUDIO_EVQ_SIZE  32
+
+typedef struct {
+    int32_t  pitch;
+    uint16_t tag;
+    bool     on;
+} audio_evt_t;
+
+SPSC_DEFINE(evq, audio_evt_t, AUDIO_EVQ_SIZE);
+static volatile bool all_off_pending = false;
+
+// Control rate: glide, then turn pitch + modulation into a phase increment.
+// Audio rate: the increment is ramped linearly across the block.
+static void render_voice(voice_t *v, int32_t mod)
+{
+    if (v->glide_step) {
+        v->pitch += v->glide_step;
+        if ((v->glide_step > 0 && v->pitch >= v->target) ||
+            (v->glide_step < 0 && v->pitch <= v->target)) {
+            v->pitch = v->target;
+            v->glide_step = 0;
+        }
+    }
+
+    uint32_t next = pitch_to_inc(v->pitch + mod);
+    int32_t dinc = (int32_t)(next - v->inc) / AUDIO_BLOCK;
+    uint32_t inc = v->inc;
+    uint32_t ph = v->phase;
+
+    for (int i = 0; i < AUDIO_BLOCK; i++) {
+        mix[i] += (ph & 0x80000000u) ? -AUDIO_AMPL : AUDIO_AMPL;
+        ph += inc;
+        inc += (uint32_t)dinc;
+    }
+
+    v->phase = ph;
+    v->inc = next;
+}
+
+// Runs in the DMA IRQ. Integer only: one multiply per sample for the gain.
+static void render_block(uint32_t *out)
+{
+    audio_evt_t e;
+    while (spsc_pop(&evq, &e)) {
+        if (e.on) audio_note_on(e.tag, e.pitch);
+        else audio_note_off(e.tag);
+    }
+    if (all_off_pending) {
+        all_off_pending = false;
+        for (int v = 0; v < AUDIO_VOICES; v++) voices[v].gate = false;
+    }
+
+    int32_t mod = bend;
+    lfo_phase += lfo_inc;
+    if (lfo_depth) mod += (int32_t)(((int64_t)pitch_lfo_sine(lfo_phase) * lfo_depth) >> 15);
+    pitch_mod = mod;
+
+    for (int i = 0; i < AUDIO_BLOCK; i++) mix[i] = 0;
+    for (int v = 0; v < AUDIO_VOICES; v++)
+        if (voices[v].gate) render_voice(&voices[v], mod);
+
+    int32_t target = gain_target;
+    int32_t g = gain;
+    int32_t step = (target - g) / AUDIO_BLOCK;
+
+    for (int i = 0; i < AUDIO_BLOCK; i++) {
+        g += step;
+        int32_t s = (mix[i] * g) >> 16;
+        if (s > AUDIO_AMPL) s = AUDIO_AMPL;
+        if (s < -AUDIO_AMPL) s = -AUDIO_AMPL;
+        out[i] = (uint32_t)(AUDIO_MID + s) << cc_shift;
+    }
+
+    gain = target;     // drop the division remainder so we never drift
+}
+
+static void __isr audio_dma_irq(void)
+{
+    uint32_t t0 = time_us_32();
+
+    for (int i = 0; i < 2; i++) {
+        uint ch = (uint)dma_chan[i];
+        if (!dma_channel_get_irq0_status(ch)) continue;
+        dma_channel_acknowledge_irq0(ch);
+        // The other channel is playing now; rewind and refill this one.
+        dma_channel_set_read_addr(ch, audio_buf[i], false);
+        render_block(audio_buf[i]);
+    }
+    cores_load_add(CORES_LOAD_AUDIO, time_us_32() - t0);
+}
+
+void audio_init(void)
+{
+    gpio_set_function(AUDIO_PIN, GPIO_FUNC_PWM);
+    slice_num = pwm_gpio_to_slice_num(AUDIO_PIN);
+    cc_shift = (pwm_gpio_to_channel(AUDIO_PIN) == PWM_CHAN_B) ? 16 : 0;
+
+    pwm_set_enabled(slice_num, false);
+    pwm_set_clkdiv_int_frac(slice_num, AUDIO_PWM_DIV, 0);
+    pwm_set_wrap(slice_num, AUDIO_PWM_TOP);
+    pwm_set_gpio_level(AUDIO_PIN, AUDIO_MID);
+
+    for (int i = 0; i < 2; i++)
+        for (int j = 0; j < AUDIO_BLOCK; j++)
+            audio_buf[i][j] = (uint32_t)AUDIO_MID << cc_shift;
+
+    dma_chan[0] = dma_claim_unused_channel(true);
+    dma_chan[1] = dma_claim_unused_channel(true);
+
+    // Two channels chained in a ping-pong, paced by the PWM wrap.
+    for (int i = 0; i < 2; i++) {
+        dma_channel_config c = dma_channel_get_default_config(dma_chan[i]);
+        channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+        channel_config_set_read_increment(&c, true);
+        channel_config_set_write_increment(&c, false);
+        channel_config_set_dreq(&c, pwm_get_dreq(slice_num));
+        channel_config_set_chain_to(&c, dma_chan[i ^ 1]);
+
+        dma_channel_configure(dma_chan[i], &c, &pwm_hw->slice[slice_num].cc,
+                              audio_buf[i], AUDIO_BLOCK, false);
+        dma_channel_set_irq0_enabled(dma_chan[i], true);
+    }
+
+    irq_add_shared_handler(DMA_IRQ_0, audio_dma_irq,
+                           PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_0, true);
+
+    pwm_set_enabled(slice_num, true);
+    dma_channel_start(dma_chan[0]);
+}
+
+// Same tag first, then the most recently released voice (so glide starts
+// from the last note played), else steal the oldest sounding one.
+static voice_t *voice_alloc(uint16_t tag)
+{
+    voice_t *best = NULL;
+
+    for (int i = 0; i < AUDIO_VOICES; i++)
+        if (voices[i].gate && voices[i].tag == tag) return &voices[i];
+
+    for (int i = 0; i < AUDIO_VOICES; i++)
+        if (!voices[i].gate && (!best || voices[i].age > best->age)) best = &voices[i];
+    if (best) return best;
+
+    for (int i = 0; i < AUDIO_VOICES; i++)
+        if (!best || voices[i].age < best->age) best = &voices[i];
+    return best;
+}
+
+int audio_note_on(uint16_t tag, int32_t pitch)
+{
+    uint32_t irq = save_and_disable_interrupts();
+
+    voice_t *v = voice_alloc(tag);
+    uint32_t blocks = glide_blocks;
+
+    v->target = pitch;
+    if (v->used && blocks) {
+        int32_t step = (pitch - v->pitch) / (int32_t)blocks;
+        if (step == 0 && pitch != v->pitch) step = (pitch > v->pitch) ? 1 : -1;
+        v->glide_step = step;
+    } else {
+        v->pitch = pitch;
+        v->glide_step = 0;
+        v->inc = pitch_to_inc(pitch + pitch_mod);
+    }
+    v->tag = tag;
+    v->gate = true;
+    v->used = true;
+    v->age = ++voice_clock;
+
+    restore_interrupts(irq);
+    return (int)(v - voices);
+}
+
+void audio_note_off(uint16_t tag)
+{
+    uint32_t irq = save_and_disable_interrupts();
+    for (int i = 0; i < AUDIO_VOICES; i++) {
+        if (voices[i].gate && voices[i].tag == tag) {
+            voices[i].gate = false;
+            voices[i].age = ++voice_clock;
+        }
+    }
+    restore_interrupts(irq);
+}
+
+void audio_all_notes_off(void)
+{
+    uint32_t irq = save_and_disable_interrupts();
+    for (int i = 0; i < AUDIO_VOICES; i++) voices[i].gate = false;
+    restore_interrupts(irq);
+}
+
+void audio_set_glide_ms(uint16_t ms)
+{
+    glide_blocks = (uint32_t)ms * AUDIO_BLOCK_RATE / 1000u;
+}
+
+void audio_set_vibrato(uint16_t rate_centihz, int32_t depth)
+{
+    lfo_inc = (uint32_t)(((uint64_t)rate_centihz << 32) / (100u * AUDIO_BLOCK_RATE));
+    lfo_depth = depth;
+}
+
+void audio_set_bend(int32_t offset)
+{
+    bend = offset;
+}
+
+void audio_set_target_gain(uint32_t gain_q16)
+{
+    if (gain_q16 > AUDIO_GAIN_ONE) gain_q16 = AUDIO_GAIN_ONE;
+    gain_target = (int32_t)gain_q16;
+}
+
+bool audio_post_note(uint16_t tag, int32_t pitch, bool on)
+{
+    audio_evt_t e = { .pitch = pitch, .tag = tag, .on = on };
+    return spsc_push(&evq, &e);
+}
+
+void audio_post_all_off(void)
+{
+    all_off_pending = true;
+}
+
+uint32_t audio_post_dropped(void)
+{
+    return evq.dropped;
+}
+
+const spsc_t *audio_post_queue(void)
+{
+    return &evq;
+}
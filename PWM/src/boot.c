@@ -0,0 +1,44 @@
+#include "boot.h"
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "cores.h"
+
+typedef struct {
+    uint32_t   us;
+    const char *stage;
+} mark_t;
+
+static mark_t marks[2][BOOT_MARKS];
+static volatile uint8_t mark_count[2];
+
+void boot_mark(const char *stage)
+{
+    uint core = get_core_num();
+    uint8_t n = mark_count[core];
+
+    if (n >= BOOT_MARKS) return;
+    marks[core][n].us = time_us_32();
+    marks[core][n].stage = stage;
+    __dmb();
+    mark_count[core] = n + 1;
+}
+
+void boot_print(void)
+{
+    uint8_t n[2] = { mark_count[0], mark_count[1] };
+    uint8_t i[2] = { 0, 0 };
+    uint32_t prev = 0;
+
+    printf("[BOOT] timeline (ms since reset):\n");
+    while (i[0] < n[0] || i[1] < n[1]) {
+        int c = i[0] < n[0] && (i[1] >= n[1] || marks[0][i[0]].us <= marks[1][i[1]].us) ? 0 : 1;
+        const mark_t *m = &marks[c][i[c]++];
+        printf("  %4lu.%03lu  +%4lu.%03lu  core %d  %s\n",
+               (unsigned long)(m->us / 1000), (unsigned long)(m->us % 1000),
+               (unsigned long)((m->us - prev) / 1000), (unsigned long)((m->us - prev) % 1000),
+               c, m->stage);
+        prev = m->us;
+    }
+    if (!cores_lcd_ready()) printf("  LCD still coming up\n");
+}
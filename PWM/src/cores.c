@@ -0,0 +1,179 @@
+#include "cores.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "hardware/irq.h"
+#include "neotrellis.h"
+#include "anim.h"
+#include "boot.h"
+#include "lcd.h"
+#include "spsc.h"
+
+#define UI_ALARMS   4
+
+static spin_lock_t *locks[CORES_LOCK_COUNT];
+static alarm_pool_t *ui_pool;
+static volatile bool lcd_ready;
+
+static const struct {
+    const char *name;
+    uint8_t    core;
+} loads[CORES_LOAD_COUNT] = {
+    [CORES_LOAD_AUDIO]  = { "audio",  0 },
+    [CORES_LOAD_KEYPAD] = { "keypad", 0 },
+    [CORES_LOAD_ANIM]   = { "anim",   1 },
+    [CORES_LOAD_LCD]    = { "lcd",    1 },
+};
+
+typedef struct {
+    char text[CORES_LOG_LINE];
+} log_line_t;
+
+SPSC_DEFINE(log_q, log_line_t, CORES_LOG_LINES);
+
+static volatile uint32_t load_us[CORES_LOAD_COUNT];
+static volatile uint32_t ui_wait_us;         // core 1 asleep in WFE
+
+spin_lock_t *cores_lock(int which)
+{
+    return locks[which];
+}
+
+alarm_pool_t *cores_ui_pool(void)
+{
+    return ui_pool;
+}
+
+bool cores_lcd_ready(void)
+{
+    return lcd_ready;
+}
+
+void cores_load_add(int load, uint32_t us)
+{
+    load_us[load] += us;
+}
+
+void cores_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    va_start(ap, fmt);
+    if (get_core_num() == 0) {
+        vprintf(fmt, ap);
+    } else {
+        log_line_t line;
+        vsnprintf(line.text, sizeof line.text, fmt, ap);
+        spsc_push(&log_q, &line);
+    }
+    va_end(ap);
+}
+
+void cores_log_task(void)
+{
+    log_line_t line;
+
+    while (spsc_pop(&log_q, &line)) fputs(line.text, stdout);
+}
+
+// One doorbell per message. A bell rung again before core 0 answers it
+// folds into the pending one, which is all a flush request needs.
+static uint bells[CORES_MSG_COUNT];
+
+static void run_msg(uint32_t msg)
+{
+    switch (msg) {
+        case CORES_MSG_LED_SHOW: neopixel_show(); break;
+        default: break;
+    }
+}
+
+bool cores_send(uint32_t msg)
+{
+    if (msg >= CORES_MSG_COUNT) return false;
+    if (get_core_num() == 0) {
+        run_msg(msg);
+        return true;
+    }
+    multicore_doorbell_set_other_core(bells[msg]);
+    return true;
+}
+
+static void core0_bell_irq(void)
+{
+    for (uint32_t msg = 0; msg < CORES_MSG_COUNT; msg++) {
+        if (!multicore_doorbell_is_set_current_core(bells[msg])) continue;
+        multicore_doorbell_clear_current_core(bells[msg]);   // before, so a new ring re-raises
+        run_msg(msg);
+    }
+}
+
+static void core1_main(void)
+{
+    // the FIFO IRQ belongs to the flash lockout from here on
+    multicore_lockout_victim_init();
+    ui_pool = alarm_pool_create_with_unused_hardware_alarm(UI_ALARMS);
+    anim_init();
+
+    boot_mark("lcd init");
+    LCD_start();
+    boot_mark("lcd ready");
+    __dmb();
+    lcd_ready = true;
+
+    for (;;) {
+        uint32_t t0 = time_us_32();
+        LCD_task();
+        uint32_t t1 = time_us_32();
+        cores_load_add(CORES_LOAD_LCD, t1 - t0);
+
+        __wfe();        // LCD_post_key and core 1's IRQs wake us
+        ui_wait_us += time_us_32() - t1;
+    }
+}
+
+void cores_init(void)
+{
+    for (int i = 0; i < CORES_LOCK_COUNT; i++)
+        locks[i] = spin_lock_instance((uint)spin_lock_claim_unused(true));
+
+    // The SIO FIFO is left to the launch and flash lockout handshakes: on
+    // the RP2350 both cores share its one IRQ vector, which core 1's
+    // lockout handler owns. Messages ring doorbells into core 0 instead.
+    for (int i = 0; i < CORES_MSG_COUNT; i++)
+        bells[i] = (uint)multicore_doorbell_claim_unused(1u << 0, true);
+    irq_set_exclusive_handler(multicore_doorbell_irq_num(bells[0]), core0_bell_irq);
+    irq_set_enabled(multicore_doorbell_irq_num(bells[0]), true);
+
+    boot_mark("core 1 launch");
+    multicore_launch_core1(core1_main);
+}
+
+void cores_print(void)
+{
+    static uint32_t last_load[CORES_LOAD_COUNT], last_wait, last_us;
+    uint32_t now = time_us_32();
+    uint32_t dt = now - last_us;
+    uint32_t busy[2] = { 0, 0 };
+
+    if (!dt) return;
+    printf("[CORES] over %lu ms:\n", (unsigned long)(dt / 1000));
+    for (int c = 0; c < 2; c++) {
+        printf("  core %d:", c);
+        for (int i = 0; i < CORES_LOAD_COUNT; i++) {
+            if (loads[i].core != c) continue;
+            uint32_t us = load_us[i] - last_load[i];
+            last_load[i] += us;
+            busy[c] += us;
+            printf(" %s %lu.%lu%%", loads[i].name,
+                   (unsigned long)((uint64_t)us * 100 / dt), (unsigned long)((uint64_t)us * 1000 / dt % 10));
+        }
+        printf(" = %lu%% busy\n", (unsigned long)((uint64_t)busy[c] * 100 / dt));
+    }
+    uint32_t wait = ui_wait_us - last_wait;
+    last_wait += wait;
+    printf("  core 1 in WFE %lu%% (anim frames run inside it)\n", (unsigned long)((uint64_t)wait * 100 / dt));
+    spsc_print("log", &log_q);
+    last_us = now;
+}
@@ -0,0 +1,106 @@
+#include "knobs.h"
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+
+#define KNOB_DEADBAND  8        // LSBs of ADC jitter to ignore
+#define KNOB_DEADZONE  1311     // ~2% of full scale in Q16
+#define KNOB_DETENT    96       // LSBs either side of center that read as 0
+
+// DMA ring size must be a power of two in bytes
+#define KNOB_RING_BITS 3
+_Static_assert(KNOB_COUNT * sizeof(uint16_t) == (1u << KNOB_RING_BITS),
+               "knob ring size must match KNOB_COUNT");
+
+static volatile uint16_t knob_buf[KNOB_COUNT] __attribute__((aligned(1u << KNOB_RING_BITS)));
+static uint16_t knob_held[KNOB_COUNT];
+static int dma_chan;
+
+void knobs_init(void) {
+    // Setup ADC
+    adc_init();
+    for (int k = 0; k < KNOB_COUNT; k++) adc_gpio_init(KNOB_PIN(KNOB_ADC_FIRST + k));
+    adc_select_input(KNOB_ADC_FIRST);
+    adc_set_round_robin(((1u << KNOB_COUNT) - 1) << KNOB_ADC_FIRST);
+
+    // ADC FIFO
+    adc_fifo_setup(
+        true,
+        true,
+        1,
+        false,
+        false
+    );
+
+    // ~1 kHz is plenty for knobs
+    adc_set_clkdiv(48000.f);
+
+    // Setup dma: the write pointer wraps over knob_buf in step with the
+    // round robin, so knob_buf[k] always holds the latest sample of knob k
+    dma_chan = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(dma_chan);
+
+
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+
+    channel_config_set_read_increment(&c, false);
+
+    channel_config_set_write_increment(&c, true);
+
+    channel_config_set_ring(&c, true, KNOB_RING_BITS);
+
+    channel_config_set_dreq(&c, DREQ_ADC);
+
+
+    dma_channel_configure(
+        dma_chan,
+        &c,
+        knob_buf,
+        &adc_hw->fifo,
+        0,
+        false
+    );
+
+
+    dma_channel_set_trans_count(dma_chan, 0xFFFFFFFF, true);
+
+    adc_run(true);
+
+    printf("[KNOBS] DMA System initialized, %d knobs from Pin %d\n",
+           KNOB_COUNT, KNOB_PIN(KNOB_ADC_FIRST));
+}
+
+uint16_t knob_raw(int knob) {
+    uint16_t raw = knob_buf[knob] & 0x0FFF;
+
+    int diff = (int)raw - (int)knob_held[knob];
+    if (diff > KNOB_DEADBAND || diff < -KNOB_DEADBAND) knob_held[knob] = raw;
+    return knob_held[knob];
+}
+
+uint32_t knob_volume_gain(void) {
+    uint32_t v = knob_raw(KNOB_VOLUME);
+
+    // 4095^2 >> 8 = 65504, close enough to unity
+    uint32_t g = (v * v) >> 8;
+
+    if (g < KNOB_DEADZONE) g = 0; //dead zone
+    return g;
+}
+
+int32_t knob_bend(int32_t range) {
+    int32_t v = (int32_t)knob_raw(KNOB_BEND) - 2048;
+
+    if (v > KNOB_DETENT)       v -= KNOB_DETENT;
+    else if (v < -KNOB_DETENT) v += KNOB_DETENT;
+    else                       return 0;
+
+    // remaining travel is 2048 - KNOB_DETENT counts each way; fits 32 bits
+    // for ranges up to an octave
+    return v * range / (2048 - KNOB_DETENT);
+}
+
+int32_t knob_scaled(int knob, int32_t lo, int32_t hi) {
+    return lo + (int32_t)knob_raw(knob) * (hi - lo) / 4095;
+}
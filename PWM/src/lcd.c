@@ -72,12 +72,18 @@ static void tft_reg_select(int val)
     }
 }
 
+// ILI9341 reset timing: RESX low for at least 10 us, 5 ms before the first
+// command, and no Sleep Out until 120 ms after release. The 120 ms runs as
+// a deadline behind the register writes instead of a fixed wait.
+static absolute_time_t sleep_out_at;
+
 void LCD_Reset(void)
 {
     lcddev.reset(1);      // Assert reset
-    sleep_ms(100); // Wait
+    sleep_us(20);
     lcddev.reset(0);      // De-assert reset
-    sleep_ms(50);  // Wait
+    sleep_out_at = make_timeout_time_ms(120);
+    sleep_ms(5);
 }
 
 
@@ -277,8 +283,9 @@ void LCD_Init(void (*reset)(int), void (*select)(int), void (*reg_select)(int))
     LCD_WR_DATA(0x00);
     LCD_WR_DATA(0x00);
     LCD_WR_DATA(0xef);
+    sleep_until(sleep_out_at);
     LCD_WR_REG(0x11);     // Exit Sleep
-    sleep_ms(120); // Wait 120 ms
+    sleep_ms(5);          // 5 ms before the next command
     LCD_WR_REG(0x29);     // Display on
 
     LCD_direction(USE_HORIZONTAL);
@@ -0,0 +1,298 @@
+#include "looper.h"
+#include "audio.h"
+#include "tuning.h"
+#include "neotrellis.h"
+#include "anim.h"
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include <stdio.h>
+
+_Static_assert(TUNING_KEYS <= 16, "loop_event_t has a 4-bit key field");
+
+static const char *state_names[] = { "idle", "recording", "playing", "overdubbing", "stopped" };
+
+static loop_event_t events[LOOPER_CAPACITY];
+static volatile uint32_t n_events = 0;
+static loop_event_t stage[LOOPER_STAGE];
+static volatile uint32_t n_stage = 0;
+static uint32_t dropped = 0;
+
+static volatile looper_state_t state = LOOPER_IDLE;
+static volatile uint64_t loop_start_us;     // start of the current pass
+static uint32_t loop_len_us;
+static uint8_t layer = 0;                   // layer being recorded
+static uint8_t layers = 0;                  // layers in events[]
+static volatile uint32_t quant_us = 0;
+
+// Alarm-side state
+static alarm_id_t alarm_id = 0;
+static bool alarm_armed = false;
+static uint32_t cursor = 0;                 // next event to play
+static uint64_t target_us;
+static uint16_t sounding = 0;               // keys the loop holds down
+
+// Timing error of playback callbacks against their targets
+static uint32_t err_max_us = 0;
+static uint64_t err_sum_us = 0;
+static uint32_t err_count = 0;
+
+static uint32_t event_due(loop_event_t e)
+{
+    uint32_t t = LOOP_EVENT_TIME(e);
+    uint32_t q = quant_us;
+    if (q) {
+        t = (t + q / 2) / q * q;            // monotonic, so order is kept
+        if (t >= loop_len_us) t = loop_len_us - 1;
+    }
+    return t;
+}
+
+static void play_event(loop_event_t e)
+{
+    int key = (int)LOOP_EVENT_KEY(e);
+    uint16_t bit = (uint16_t)(1u << key);
+
+    if (LOOP_EVENT_PRESS(e)) {
+        audio_note_on((uint8_t)(LOOPER_TAG_BASE + key), tuning_key(key)->pitch);
+        anim_key(key, true);
+        sounding |= bit;
+    } else {
+        audio_note_off((uint8_t)(LOOPER_TAG_BASE + key));
+        anim_key(key, false);
+        sounding &= (uint16_t)~bit;
+    }
+}
+
+static void release_all(void)
+{
+    while (sounding) {
+        int key = __builtin_ctz(sounding);
+        sounding &= sounding - 1;
+        audio_note_off((uint8_t)(LOOPER_TAG_BASE + key));
+        anim_key(key, false);
+    }
+}
+
+// Both runs are sorted and events[] has room after its last entry, so a
+// merge from the back needs no scratch space.
+static void merge_stage(void)
+{
+    uint32_t m = n_stage;
+    if (!m) return;
+
+    int32_t i = (int32_t)n_events - 1;
+    int32_t j = (int32_t)m - 1;
+    int32_t k = (int32_t)(n_events + m) - 1;
+    while (j >= 0) {
+        if (i >= 0 && events[i] > stage[j]) events[k--] = events[i--];
+        else                                events[k--] = stage[j--];
+    }
+    n_events += m;
+    n_stage = 0;
+
+    // The pass becomes a layer; the last layer soaks up any further passes
+    layers = (uint8_t)(layer + 1);
+    if (layer + 1 < LOOPER_LAYERS) layer++;
+}
+
+static int64_t looper_tick(alarm_id_t id, void *user)
+{
+    uint64_t now_target = target_us;
+    uint32_t err = (uint32_t)(time_us_64() - now_target);
+    if (err > err_max_us) err_max_us = err;
+    err_sum_us += err;
+    err_count++;
+
+    uint32_t pos = (uint32_t)(now_target - loop_start_us);
+
+    // Everything due at this time, then look at the next one
+    while (cursor < n_events && event_due(events[cursor]) <= pos)
+        play_event(events[cursor++]);
+
+    if (cursor >= n_events) {
+        if (pos >= loop_len_us) {
+            // Wrap: fold in the overdub pass and start over
+            release_all();
+            merge_stage();
+            loop_start_us += loop_len_us;
+            cursor = 0;
+            pos = 0;
+            while (cursor < n_events && event_due(events[cursor]) == 0)
+                play_event(events[cursor++]);
+            if (cursor >= n_events) {
+                target_us = loop_start_us + loop_len_us;
+                return -(int64_t)(target_us - now_target);
+            }
+        } else {
+            target_us = loop_start_us + loop_len_us;
+            return -(int64_t)(target_us - now_target);
+        }
+    }
+
+    target_us = loop_start_us + event_due(events[cursor]);
+    if (target_us <= now_target) target_us = now_target + 1;
+    return -(int64_t)(target_us - now_target);
+}
+
+static void start_playback(void)
+{
+    cursor = 0;
+    sounding = 0;
+    target_us = loop_start_us;
+    alarm_id = add_alarm_at(from_us_since_boot(target_us), looper_tick, NULL, true);
+    alarm_armed = true;
+}
+
+static void stop_playback(void)
+{
+    if (alarm_armed) cancel_alarm(alarm_id);
+    alarm_armed = false;
+    release_all();
+}
+
+static void record(int idx, bool pressed)
+{
+    uint32_t irq = save_and_disable_interrupts();
+    uint64_t now = time_us_64();
+    uint32_t t = (uint32_t)(now - loop_start_us);
+
+    if (state == LOOPER_RECORDING) {
+        if (t <= LOOPER_MAX_US && n_events < LOOPER_CAPACITY)
+            events[n_events++] = LOOP_EVENT(t, layer, pressed, idx);
+        else
+            dropped++;
+    } else if (state == LOOPER_OVERDUBBING) {
+        if (t >= loop_len_us) t = loop_len_us - 1;      // wrap is a little late
+        if (n_stage < LOOPER_STAGE && n_events + n_stage < LOOPER_CAPACITY)
+            stage[n_stage++] = LOOP_EVENT(t, layer, pressed, idx);
+        else
+            dropped++;
+    }
+    restore_interrupts(irq);
+}
+
+void looper_key(int idx, bool pressed)
+{
+    if ((unsigned)idx >= TUNING_KEYS) return;     // extra tiles carry no notes
+    record(idx, pressed);
+    neotrellis_play_key(idx, pressed);
+}
+
+void looper_advance(void)
+{
+    switch (state) {
+        case LOOPER_IDLE:
+            looper_clear();
+            loop_start_us = time_us_64();
+            state = LOOPER_RECORDING;
+            break;
+        case LOOPER_RECORDING: {
+            uint64_t now = time_us_64();
+            uint32_t len = (uint32_t)(now - loop_start_us);
+            loop_len_us = len > LOOPER_MAX_US ? LOOPER_MAX_US : len;
+            if (loop_len_us == 0) loop_len_us = 1;
+            layers = 1;
+            layer = 1;
+            loop_start_us = now;
+            state = LOOPER_PLAYING;
+            start_playback();
+            break;
+        }
+        case LOOPER_PLAYING:
+            state = LOOPER_OVERDUBBING;
+            break;
+        case LOOPER_OVERDUBBING:
+            // The pass is merged at the next wrap either way
+            state = LOOPER_PLAYING;
+            break;
+        case LOOPER_STOPPED:
+            // Resume from the top of the kept loop
+            loop_start_us = time_us_64();
+            state = LOOPER_PLAYING;
+            start_playback();
+            break;
+    }
+}
+
+void looper_stop(void)
+{
+    stop_playback();
+    if (state == LOOPER_RECORDING) {
+        n_events = 0;
+        state = LOOPER_IDLE;
+    } else if (state == LOOPER_PLAYING || state == LOOPER_OVERDUBBING) {
+        uint32_t irq = save_and_disable_interrupts();
+        merge_stage();
+        restore_interrupts(irq);
+        state = LOOPER_STOPPED;     // events and length kept for space to resume
+    }
+}
+
+void looper_clear(void)
+{
+    stop_playback();
+    n_events = 0;
+    n_stage = 0;
+    layers = 0;
+    layer = 0;
+    loop_len_us = 0;
+    dropped = 0;
+    err_max_us = 0;
+    err_sum_us = 0;
+    err_count = 0;
+    state = LOOPER_IDLE;
+}
+
+bool looper_undo(void)
+{
+    if (layers <= 1) return false;
+
+    uint32_t irq = save_and_disable_interrupts();
+    uint8_t top = (uint8_t)(layers - 1);
+    uint32_t w = 0, played = 0;
+    for (uint32_t r = 0; r < n_events; r++) {
+        if (LOOP_EVENT_LAYER(events[r]) == top) continue;
+        if (r < cursor) played++;       // the pass resumes after these
+        events[w++] = events[r];
+    }
+    n_events = w;
+    n_stage = 0;
+    layers = top;
+    layer = top;
+    cursor = played;
+    release_all();
+    restore_interrupts(irq);
+    return true;
+}
+
+looper_state_t looper_state(void)
+{
+    return state;
+}
+
+void looper_set_quantize_us(uint32_t grid_us)
+{
+    quant_us = grid_us;
+}
+
+void looper_poll(void)
+{
+    if (state == LOOPER_RECORDING && time_us_64() - loop_start_us > LOOPER_MAX_US) {
+        printf("[LOOP] max length reached, closing the loop\n");
+        looper_advance();
+    }
+}
+
+void looper_print(void)
+{
+    printf("[LOOP] %s, %lu.%03lu s, %u layer(s), quantize %lu us\n",
+           state_names[state], (unsigned long)(loop_len_us / 1000000u),
+           (unsigned long)(loop_len_us / 1000u % 1000u), layers, (unsigned long)quant_us);
+    printf("[LOOP] %lu/%u events (%u bytes each, %u per KB), %lu staged, %lu dropped\n",
+           (unsigned long)n_events, LOOPER_CAPACITY, (unsigned)sizeof(loop_event_t),
+           (unsigned)(1024 / sizeof(loop_event_t)), (unsigned long)n_stage, (unsigned long)dropped);
+    if (err_count)
+        printf("[LOOP] timing error avg %lu us, max %lu us over %lu callbacks\n",
+               (unsigned long)(err_sum_us / err_count), (unsigned long)err_max_us,
+               (unsigned long)err_count);
+}
@@ -1,195 +1,359 @@
 #include <stdio.h>
 #include "pico/stdlib.h"
-#include "hardware/pwm.h"
-#include "hardware/adc.h"
-#include "hardware/dma.h"
 #include "neotrellis.h"
 #include "seesaw.h"
 #include "tusb_config.h"
 #include "lcd.h"
+#include "audio.h"
+#include "knobs.h"
+#include "tuning.h"
+#include "seq.h"
+#include "arp.h"
+#include "looper.h"
+#include "smf_player.h"
+#include "usb_midi.h"
+#include "uart_midi.h"
+#include "anim.h"
+#include "boot.h"
+#include "cores.h"
+#include "sched.h"
+
+
+#define BEND_RANGE      (2 * PITCH_SEMITONE)
+#define GLIDE_MS        30
+#define VIBRATO_RATE    550             // 5.5 Hz
+#define VIBRATO_DEPTH   (8 * PITCH_CENT)
+
+// Main-loop task periods
+#define CONTROL_US      2000            // knobs -> audio, about one block
+#define LOOPER_US       10000
+#define TELEMETRY_US    1000000
+#define BOOT_LOG_US     3000000         // after keypad live, once USB is up
 
 
-#define BUZZER_PIN 15  
-#define VOL_PIN 45      
-#define VOL_CHAN 5      
-#define SYS_CLK_FREQ 150000000 
-
-// GLOBALS 
-static uint slice_num;
-static uint32_t current_top = 0;
-volatile uint32_t volume_raw = 0;
-
-void init_volume_system(void) {
-    adc_init();
-    adc_gpio_init(VOL_PIN);
-    adc_select_input(VOL_CHAN);
-    adc_fifo_setup(true, true, 1, false, false);
-    adc_set_clkdiv(48000.f);
-
-    int dma_chan = dma_claim_unused_channel(true);
-    dma_channel_config c = dma_channel_get_default_config(dma_chan);
-    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
-    channel_config_set_read_increment(&c, false);
-    channel_config_set_write_increment(&c, false);
-    channel_config_set_dreq(&c, DREQ_ADC);
-
-    dma_channel_configure(dma_chan, &c, &volume_raw, &adc_hw->fifo, 0, false);
-    dma_channel_set_trans_count(dma_chan, 0xFFFFFFFF, true); 
-    adc_run(true);
+void pwm_audio_init(void) {
+    audio_init();
+    audio_set_glide_ms(GLIDE_MS);
+    audio_set_vibrato(VIBRATO_RATE, VIBRATO_DEPTH);
 }
 
-float get_volume_scalar(void) {
-   
-    float current_input = (float)volume_raw / 4095.0f;
-
-    static float smoothed_vol = 0.0f;
-    smoothed_vol = (0.9f * smoothed_vol) + (0.1f * current_input);
-    float v = smoothed_vol;
+// Hands the knobs to the renderer as targets; the renderer ramps gain and
+// pitch per sample, so how often this runs no longer matters.
+void pwm_update_volume(void) {
+    audio_set_target_gain(knob_volume_gain());
+    audio_set_bend(knob_bend(BEND_RANGE));
+}
 
-   // if (v < 0.02f) v = 0.0f;
 
-    return v; 
+void play_note(int idx) {
+    static bool first = true;
+
+    if (idx >= 0 && idx < TUNING_KEYS) {
+        if (first) boot_mark("first note");
+        first = false;
+        const tuning_key_t *k = tuning_key(idx);
+        audio_post_note((uint8_t)idx, k->pitch, true);
+        usb_midi_send_note(k->note, 100, true);
+        uart_midi_send_note(k->note, 100, true);
+    }
 }
 
-
-void pwm_audio_init(void) {
-    gpio_set_function(BUZZER_PIN, GPIO_FUNC_PWM);
-    slice_num = pwm_gpio_to_slice_num(BUZZER_PIN);
-    pwm_set_enabled(slice_num, false);
-    
-    // Reset divider to default!!!
-    pwm_set_clkdiv(slice_num, 1.0f);
+void stop_note(int idx) {
+    if (idx >= 0 && idx < TUNING_KEYS) {
+        audio_post_note((uint8_t)idx, 0, false);
+        usb_midi_send_note(tuning_key(idx)->note, 0, false);
+        uart_midi_send_note(tuning_key(idx)->note, 0, false);
+    }
 }
 
-void pwm_play_tone(uint16_t freq) {
-    if (freq == 0) {
-        pwm_set_enabled(slice_num, false);
-        current_top = 0;
-        return;
+typedef enum {
+    MODE_PLAY,
+    MODE_SEQ,
+    MODE_ARP,
+    MODE_LOOP,
+    MODE_COUNT
+} app_mode_t;
+
+static const char *mode_names[MODE_COUNT] = { "play", "sequencer", "arpeggiator", "looper" };
+static app_mode_t mode = MODE_PLAY;
+
+static void set_mode(app_mode_t m) {
+    if (m == mode) return;
+
+    if (mode == MODE_SEQ) seq_stop();
+    if (mode == MODE_ARP) arp_stop();
+    if (mode == MODE_LOOP) looper_stop();
+    anim_enable(m == MODE_PLAY || m == MODE_LOOP);
+    audio_all_notes_off();
+    neopixel_fill_all_and_show(0, 0, 0);
+
+    mode = m;
+    switch (mode) {
+        case MODE_SEQ:
+            neotrellis_set_key_handler(seq_key);
+            seq_start();
+            seq_redraw();
+            break;
+        case MODE_ARP:
+            neotrellis_set_key_handler(arp_key);
+            arp_start();
+            break;
+        case MODE_LOOP:
+            neotrellis_set_key_handler(looper_key);
+            break;
+        default:
+            neotrellis_set_key_handler(NULL);
+            break;
     }
+    printf("[MODE] %s\n", mode_names[mode]);
+}
 
-    uint32_t system_clock = SYS_CLK_FREQ;
-    uint32_t top = 0;
-    float divider = 1.0f;
+static bool console_tuning(int c) {
+    switch (c) {
+        case 's': tuning_set_scale((scale_t)((tuning_scale() + 1) % SCALE_COUNT)); break;
+        case 't': tuning_set_temperament((temperament_t)((tuning_temperament() + 1) % TEMPER_COUNT)); break;
+        case '>': tuning_set_root((uint8_t)(tuning_root() + 1)); break;
+        case '<': tuning_set_root((uint8_t)(tuning_root() + 11)); break;
+        case '+': tuning_set_octave((int8_t)(tuning_octave() + 1)); break;
+        case '-': tuning_set_octave((int8_t)(tuning_octave() - 1)); break;
+        default:  return false;
+    }
+    audio_all_notes_off();
+    tuning_print();
+    return true;
+}
 
+static bool console_seq(int c) {
+    switch (c) {
+        case '1': case '2': case '3': case '4': seq_select_track(c - '1'); break;
+        case '[': seq_select_pattern((seq_pattern() + SEQ_PATTERNS - 1) % SEQ_PATTERNS); break;
+        case ']': seq_select_pattern((seq_pattern() + 1) % SEQ_PATTERNS); break;
+        case 'c': seq_chain_append(seq_pattern()); break;
+        case 'x': seq_chain_clear(); break;
+        case '{': seq_set_bpm((uint16_t)(seq_bpm() - 5)); break;
+        case '}': seq_set_bpm((uint16_t)(seq_bpm() + 5)); break;
+        case ' ': if (seq_running()) seq_stop(); else seq_start(); break;
+        default:  return false;
+    }
+    seq_print();
+    return true;
+}
 
-    uint32_t count = system_clock / freq;
+static bool console_arp(int c) {
+    switch (c) {
+        case 'm': arp_set_mode((arp_mode_t)((arp_mode() + 1) % ARP_MODE_COUNT)); break;
+        case 'r': arp_set_rate((arp_rate_t)((arp_rate() + 1) % ARP_RATE_COUNT)); break;
+        case 'l': arp_set_latch(!arp_latch()); break;
+        case '{': seq_set_bpm((uint16_t)(seq_bpm() - 5)); break;
+        case '}': seq_set_bpm((uint16_t)(seq_bpm() + 5)); break;
+        default:  return false;
+    }
+    arp_print();
+    return true;
+}
 
-    // Fit into 16-bit (Max 65535)
-    if (count < 65535) {
-        top = count - 1;
-        divider = 1.0f;
-    } else {
-        divider = 16.0f;
-        top = (system_clock / (freq * 16)) - 1;
-        
-        // IF too big, divide more
-        if (top > 65535) {
-            divider = 128.0f;
-            top = (system_clock / (freq * 128)) - 1;
-        }
+static bool console_loop(int c) {
+    static uint8_t quant = 0;      // off, 1/16, 1/8
+
+    switch (c) {
+        case ' ': looper_advance(); break;
+        case 'x': looper_stop(); break;
+        case 'z': looper_clear(); break;
+        case 'u': looper_undo(); break;
+        case 'k':
+            quant = (uint8_t)((quant + 1) % 3);
+            // one 16th note is a quarter of a beat
+            looper_set_quantize_us(quant ? (15000000u / seq_bpm()) * quant : 0);
+            break;
+        case 'i': break;
+        default:  return false;
     }
+    looper_print();
+    return true;
+}
 
-    current_top = top;
+static bool telemetry = false;
 
-    // 50% Duty Cycle
-    uint16_t level = top / 2;
-    
-    pwm_set_clkdiv(slice_num, divider); 
-    pwm_set_wrap(slice_num, (uint16_t)top);
-    pwm_set_gpio_level(BUZZER_PIN, level); //Channel B)
-    pwm_set_enabled(slice_num, true);
+// Single-character commands over USB serial; never blocks.
+static void console_poll(void) {
+    int c = getchar_timeout_us(0);
+    if (c == PICO_ERROR_TIMEOUT) return;
 
-    printf("PLAYING: %d Hz | Div: %.1f | Top: %d | Level: %d\n", freq, divider, top, level);
+    if (c == 'q') {
+        set_mode(mode == MODE_SEQ ? MODE_PLAY : MODE_SEQ);
+        return;
+    }
+    if (c == 'a') {
+        set_mode(mode == MODE_ARP ? MODE_PLAY : MODE_ARP);
+        return;
+    }
+    if (c == 'o') {
+        set_mode(mode == MODE_LOOP ? MODE_PLAY : MODE_LOOP);
+        return;
+    }
+    if (c == 'j') {
+        if (smf_player_playing()) smf_player_stop();
+        else smf_player_start(smf_player_song(), true);
+        smf_player_print();
+        return;
+    }
+    if (c == 'n') {
+        smf_player_start((smf_player_song() + 1) % smf_song_count, true);
+        smf_player_print();
+        return;
+    }
+    if (c == 'M') {
+        usb_midi_print();
+        uart_midi_print();
+        return;
+    }
+    if (c == 'I') {
+        neotrellis_keypad_set_irq(!neotrellis_keypad_irq());
+        neotrellis_keypad_print();
+        return;
+    }
+    if (c == 'B') {
+        neotrellis_keypad_print();
+        seesaw_engine_print();
+        neopixel_fb_print();
+        anim_print();
+        return;
+    }
+    if (c == 'D') {
+        neotrellis_topology_init(true);
+        neotrellis_negotiate_speed();
+        neotrellis_topology_save();
+        seesaw_engine_print();
+        return;
+    }
+    if (c == 'C') {
+        neotrellis_calibrate();
+        return;
+    }
+    if (c == 'S') {
+        neotrellis_bus_benchmark();
+        return;
+    }
+    if (c == 'Q') {
+        printf("[QUEUES]\n");
+        spsc_print("audio", audio_post_queue());
+        spsc_print("led", anim_key_queue());
+        spsc_print("lcd", LCD_key_queue());
+        return;
+    }
+    if (c == 'U') {
+        cores_print();
+        sched_print();
+        return;
+    }
+    if (c == 'W') {
+        telemetry = !telemetry;
+        printf("[SCHED] telemetry %s\n", telemetry ? "on" : "off");
+        return;
+    }
+    if (c == 'T') {
+        boot_print();
+        return;
+    }
+    if (c == 'L') {
+        uart_midi_loopback_test();
+        return;
+    }
+    if (console_tuning(c)) return;
+    if (mode == MODE_SEQ) console_seq(c);
+    if (mode == MODE_ARP) console_arp(c);
+    if (mode == MODE_LOOP) console_loop(c);
 }
 
+static void keypad_task(void) {
+    neotrellis_poll_buttons(NULL);
+}
 
-void pwm_update_volume(void) {
-    if (current_top > 0) {
-        
-        float vol = get_volume_scalar();
-        
-        uint16_t level = (uint16_t)((current_top / 2) * vol);
-        
-       
-        pwm_set_gpio_level(BUZZER_PIN, level);
+static void control_task(void) {
+    pwm_update_volume();
+    if (mode == MODE_ARP) {
+        arp_set_gate((uint16_t)knob_scaled(KNOB_GATE, 26, 256));     // 10% .. legato
+        arp_set_swing((uint16_t)knob_scaled(KNOB_SWING, 0, 256));
     }
 }
 
-
-static const uint16_t notes[16] = {
-    262, 294, 330, 349, 392, 440, 494, 523, 
-    587, 659, 698, 784, 880, 988, 1047, 1175 
-};
-
-
-void play_note(int idx) {
-    if (idx >= 0 && idx < 16) pwm_play_tone(notes[idx]);
+static void led_task(void) {
+    if (mode == MODE_SEQ) seq_update_leds();
+    if (mode == MODE_ARP) arp_update_leds();
 }
 
-void stop_note(void) {
-    pwm_play_tone(0);
+static void looper_task(void) {
+    if (mode == MODE_LOOP) looper_poll();
 }
 
-static void scan_i2c(void) {
-    printf("I2C scan:\n");
-    for (uint8_t a = 0x08; a <= 0x77; a++) {
-        uint8_t dummy = 0;
-        int r = i2c_write_blocking(NEOTRELLIS_I2C, a, &dummy, 1, false);
-        if (r >= 0) printf("  Found 0x%02X\n", a);
-    }
+static void telemetry_task(void) {
+    if (!telemetry) return;
+    cores_print();
+    sched_print();
 }
 
 int main() {
+    usb_midi_init();
     stdio_init_all();
     setvbuf(stdout, NULL, _IONBF, 0);   
-    sleep_ms(500);    
+    boot_mark("stdio");
+
+    // core 1 takes the LCD and LED frames; its LCD reset and sleep-out
+    // waits overlap everything below
+    cores_init();
 
     seesaw_bus_init(400000);
+    tuning_init();
     pwm_audio_init();  
-    init_volume_system();
-    scan_i2c();
+    knobs_init();
+    uart_midi_init();
+    seq_init();
+    boot_mark("audio + midi");
+    bool cached = neotrellis_topology_init(false);
+    boot_mark(cached ? "topology cached" : "topology scanned");
     
-    if (!neotrellis_reset()) while (1); 
-    sleep_ms(1000);
-    if (!neotrellis_wait_ready(500)) return 0;
-    if (!neopixel_begin(3)) {
-        while(1){
-            tight_loop_contents();
-        }
+    // a missing or wedged trellis is reported, not fatal: audio and MIDI
+    // still work, and the transport keeps retrying the bus
+    bool trellis = neotrellis_reset() && neotrellis_wait_ready(1500) && neopixel_begin(3);
+    boot_mark("trellis up");
+    if (!trellis) {
+        printf("[neo] NeoTrellis not ready, continuing without it\n");
+        seesaw_engine_print();
+    }
+    if (trellis && !cached) {
+        neotrellis_negotiate_speed();
+        neotrellis_topology_save();
+        boot_mark("speed negotiated");
     }
 
-
-    uint8_t speed = 0x01;  
-    seesaw_write(NEOTRELLIS_ADDR, SEESAW_NEOPIXEL_BASE, NEOPIXEL_SPEED, &speed, 1);
-    sleep_ms(300);
-    
-    LCD_start();
-    neotrellis_rainbow_startup();
+    // the rainbow runs off core 1's frame timer while the keypad comes up
+    anim_enable(true);
+    anim_rainbow(2 * ANIM_FPS);
     
-    sleep_ms(200);
     fflush(stdout);
     neotrellis_keypad_init();
+    if (trellis) neotrellis_timing_init(true);
     
-    sleep_ms(200);
     neotrellis_clear_fifo(); 
+    neotrellis_keypad_irq_init();
+    boot_mark("keypad live");
 
+    printf("[boot] keypad live %lu ms after reset%s\n",
+           (unsigned long)to_ms_since_boot(get_absolute_time()), cached ? "" : " (full scan)");
     printf("DIAGNOSTIC MODE: PRESS A BUTTON\n");
-    
-    int idx = -1;
-    uint32_t last_print = 0;
-
-    while (1) {
-        neotrellis_poll_buttons(&idx);
-        pwm_update_volume();
 
-        // uint32_t now = to_ms_since_boot(get_absolute_time());
-        // if (now - last_print > 200) {
-        //     printf("Knob Raw: %4d | Vol: %.2f\r", volume_raw, get_volume_scalar());
-        //     last_print = now;
-        // }
-
-      
-    }
+    // USB, UART and keypad work arrives by IRQ, so those run every pass
+    sched_add("usb", usb_midi_task, SCHED_POLL);
+    sched_add("uart", uart_midi_task, SCHED_POLL);
+    sched_add("keypad", keypad_task, SCHED_POLL);
+    sched_add("console", console_poll, SCHED_POLL);
+    sched_add("log", cores_log_task, SCHED_POLL);       // core 1's lines
+    sched_add("control", control_task, CONTROL_US);
+    sched_add("leds", led_task, ANIM_FRAME_US);
+    sched_add("looper", looper_task, LOOPER_US);
+    sched_add("telemetry", telemetry_task, TELEMETRY_US);
+    sched_at(sched_add("boot log", boot_print, SCHED_ONCE), time_us_32() + BOOT_LOG_US);
+
+    sched_run();
     return 0;
 }
\ No newline at end of file
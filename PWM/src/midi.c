@@ -0,0 +1,127 @@
+#include "midi.h"
+
+uint8_t midi_msg_len(uint8_t status)
+{
+    if (status < 0x80) return 0;
+    if (status < 0xF0) return ((status & 0xE0) == 0xC0) ? 2 : 3;   // program change / channel pressure
+    switch (status) {
+        case 0xF1: case 0xF3: return 2;
+        case 0xF2:            return 3;
+        case 0xF6:            return 1;
+        default:              return status >= 0xF8 ? 1 : 0;
+    }
+}
+
+void midi_parser_reset(midi_parser_t *p)
+{
+    p->status = 0;
+    p->need = 0;
+    p->have = 0;
+    p->in_sysex = false;
+}
+
+bool midi_parse_byte(midi_parser_t *p, uint8_t b, midi_msg_t *out)
+{
+    if (b >= 0xF8) {                        // real-time: no effect on state
+        out->status = b;
+        out->d1 = out->d2 = 0;
+        out->len = 1;
+        return true;
+    }
+
+    if (b & 0x80) {
+        p->in_sysex = (b == 0xF0);
+        p->have = 0;
+        uint8_t len = midi_msg_len(b);
+        if (len == 0) {                     // sysex start/end, undefined
+            p->status = 0;
+            return false;
+        }
+        p->status = b;
+        p->need = (uint8_t)(len - 1);
+        if (p->need == 0) {                 // tune request
+            out->status = b;
+            out->d1 = out->d2 = 0;
+            out->len = 1;
+            p->status = 0;
+            return true;
+        }
+        return false;
+    }
+
+    if (p->in_sysex || p->status == 0) return false;
+
+    p->data[p->have++] = b;
+    if (p->have < p->need) return false;
+
+    out->status = p->status;
+    out->d1 = p->data[0];
+    out->d2 = (p->need == 2) ? p->data[1] : 0;
+    out->len = (uint8_t)(p->need + 1);
+    p->have = 0;
+    if (p->status >= 0xF0) p->status = 0;   // only channel messages run on
+    return true;
+}
+
+size_t midi_encode(const midi_msg_t *m, uint8_t *out, uint8_t *running)
+{
+    uint8_t len = midi_msg_len(m->status);
+    size_t n = 0;
+
+    if (len == 0) return 0;
+
+    if (m->status >= 0xF8) {                // real-time never touches running status
+        out[0] = m->status;
+        return 1;
+    }
+    if (running) {
+        if (m->status < 0xF0 && *running == m->status) {
+            len--;                          // status byte omitted
+            if (len >= 1) out[n++] = m->d1;
+            if (len >= 2) out[n++] = m->d2;
+            return n;
+        }
+        *running = (m->status < 0xF0) ? m->status : 0;
+    }
+
+    out[n++] = m->status;
+    if (len >= 2) out[n++] = m->d1;
+    if (len >= 3) out[n++] = m->d2;
+    return n;
+}
+
+void midi_to_usb(const midi_msg_t *m, uint8_t cable, uint8_t pkt[4])
+{
+    uint8_t cin;
+    if (m->status < 0xF0)       cin = m->status >> 4;
+    else if (m->status >= 0xF8) cin = 0xF;
+    else                        cin = (uint8_t[]){ 0, 0x5, 0x2, 0x3 }[midi_msg_len(m->status)];
+
+    pkt[0] = (uint8_t)((cable << 4) | cin);
+    pkt[1] = m->status;
+    pkt[2] = m->d1;
+    pkt[3] = m->d2;
+}
+
+bool midi_from_usb(const uint8_t pkt[4], midi_msg_t *m)
+{
+    uint8_t cin = pkt[0] & 0x0F;
+
+    switch (cin) {
+        case 0x2: case 0x3: case 0x5:       // system common (0x5 may also end a sysex)
+        case 0x8: case 0x9: case 0xA: case 0xB:
+        case 0xC: case 0xD: case 0xE: case 0xF:
+            break;
+        default:                            // sysex and reserved codes
+            return false;
+    }
+
+    uint8_t len = midi_msg_len(pkt[1]);
+    if (len == 0) return false;
+
+    m->status = pkt[1];
+    m->d1 = (len >= 2) ? (pkt[2] & 0x7F) : 0;
+    m->d2 = (len >= 3) ? (pkt[3] & 0x7F) : 0;
+    m->len = len;
+    return true;
+}
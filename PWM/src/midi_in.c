@@ -0,0 +1,29 @@
+#include "midi_in.h"
+#include "audio.h"
+
+static uint32_t rx_msgs = 0;
+static uint32_t rx_notes = 0;
+
+void midi_in_dispatch(const midi_msg_t *m)
+{
+    rx_msgs++;
+
+    if (midi_is_note_on(m)) {
+        audio_post_note(MIDI_TAG(m->d1), PITCH_MIDI(m->d1), true);
+        rx_notes++;
+    } else if (midi_is_note_off(m)) {
+        audio_post_note(MIDI_TAG(m->d1), 0, false);
+    } else if ((m->status & 0xF0) == 0xB0 && (m->d1 == 120 || m->d1 == 123)) {
+        audio_post_all_off();          // all sound off / all notes off
+    }
+}
+
+uint32_t midi_in_messages(void)
+{
+    return rx_msgs;
+}
+
+uint32_t midi_in_notes(void)
+{
+    return rx_notes;
+}
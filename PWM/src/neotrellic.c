@@ -2,51 +2,561 @@
 #include "seesaw.h"
 #include "pico/stdlib.h"
 #include "hardware/pwm.h"
+#include "hardware/sync.h"
 #include <string.h>
 #include <stdio.h>
 #include "lcd.h"
+#include "anim.h"
+#include "persist.h"
+#include "cores.h"
+#include "sched.h"
 
 extern void play_note(int idx);
-extern void stop_note(void);
-
-// === PWM AUDIO SETUP ===
-#define BUZZER_PIN 15  // Change this to whatever GPIO pin you want to use
-#define SYS_CLK_FREQ 150000000  // RP2350 runs at 150 MHz
-
-// Musical notes (frequencies in Hz) - C Major scale across 2 octaves
-static const uint16_t notes[16] = {
-    262,  // C4  - Button 0  (Do)
-    294,  // D4  - Button 1  (Re)
-    330,  // E4  - Button 2  (Mi)
-    349,  // F4  - Button 3  (Fa)
-    392,  // G4  - Button 4  (Sol)
-    440,  // A4  - Button 5  (La)
-    494,  // B4  - Button 6  (Ti)
-    523,  // C5  - Button 7  (Do - higher octave)
-    
-    587,  // D5  - Button 8  (Re)
-    659,  // E5  - Button 9  (Mi)
-    698,  // F5  - Button 10 (Fa)
-    784,  // G5  - Button 11 (Sol)
-    880,  // A5  - Button 12 (La)
-    988,  // B5  - Button 13 (Ti)
-    1047, // C6  - Button 14 (Do - even higher!)
-    1175  // D6  - Button 15 (Re)
+extern void stop_note(int idx);
+
+// === UNCHANGED CODE BELOW ===
+
+// === Seesaw timing ===
+// Read delays and settle times for the registers this driver touches, after
+// how the ATSAMD09 seesaw firmware serves them: status registers come
+// straight from RAM, KEYPAD_COUNT and the FIFO are answered from the scan
+// loop, and NeoPixel writes keep the chip busy while it reallocates or
+// shifts data out with interrupts off (30 us per pixel at 800 kHz).
+#define SHOW_SETTLE_US  (NEOTRELLIS_TILE_KEYS * 30 + 100)
+
+static const seesaw_timing_t timing_defaults[] = {
+    { SEESAW_STATUS_BASE,   SEESAW_STATUS_HW_ID,   250, 0 },
+    { SEESAW_STATUS_BASE,   SEESAW_STATUS_VERSION, 250, 0 },
+    { SEESAW_STATUS_BASE,   SEESAW_STATUS_SWRST,     0, 2000 },
+    { SEESAW_NEOPIXEL_BASE, NEOPIXEL_PIN,            0, 300 },
+    { SEESAW_NEOPIXEL_BASE, NEOPIXEL_SPEED,          0, 300 },
+    { SEESAW_NEOPIXEL_BASE, NEOPIXEL_BUF_LENGTH,     0, 1000 },
+    { SEESAW_NEOPIXEL_BASE, NEOPIXEL_BUF,            0, 0 },
+    { SEESAW_NEOPIXEL_BASE, NEOPIXEL_SHOW,           0, SHOW_SETTLE_US },
+    { SEESAW_KEYPAD_BASE,   KEYPAD_ENABLE,           0, 0 },
+    { SEESAW_KEYPAD_BASE,   KEYPAD_INTEN,            0, 0 },
+    { SEESAW_KEYPAD_BASE,   KEYPAD_COUNT,          500, 0 },
+    { SEESAW_KEYPAD_BASE,   KEYPAD_FIFO,           300, 0 },
 };
 
-static const char* note_names[16] = {
-    "C4", "D4", "E4", "F4", "G4", "A4", "B4", "C5",
-    "D5", "E5", "F5", "G5", "A5", "B5", "C6", "D6"
+// Readable registers the calibration measures, and what a good answer is.
+// Only registers with a known answer qualify: an empty KEYPAD_COUNT or an
+// all-0xFF FIFO is also what a read that came too early returns, so the
+// keypad registers keep their table delays.
+typedef enum { CHECK_HW_ID, CHECK_SAME } cal_check_t;
+
+typedef struct {
+    uint8_t module;
+    uint8_t reg;
+    uint8_t len;
+    cal_check_t check;
+} cal_reg_t;
+
+static const cal_reg_t cal_regs[] = {
+    { SEESAW_STATUS_BASE, SEESAW_STATUS_HW_ID,   1, CHECK_HW_ID },
+    { SEESAW_STATUS_BASE, SEESAW_STATUS_VERSION, 4, CHECK_SAME },
 };
+#define CAL_REGS        (int)count_of(cal_regs)
+#define CAL_TRIES       8       // consecutive good reads to accept a delay
+#define CAL_MIN_US      10
+#define CAL_STEP_US     8       // search resolution
+#define CAL_LEN_MAX     4       // longest register read
 
-static uint slice_num;
+typedef struct {
+    uint32_t version;           // seesaw firmware it was measured on
+    uint16_t read_us[CAL_REGS];
+} cal_record_t;
 
-// === UNCHANGED CODE BELOW ===
+static cal_record_t cal;
+static bool cal_valid = false;
+
+static void timing_defaults_apply(void)
+{
+    for (int i = 0; i < (int)count_of(timing_defaults); i++) {
+        const seesaw_timing_t *t = &timing_defaults[i];
+        seesaw_set_timing(t->module, t->reg, t->read_us, t->settle_us);
+    }
+}
+
+static uint16_t default_read_us(const cal_reg_t *c)
+{
+    for (int i = 0; i < (int)count_of(timing_defaults); i++)
+        if (timing_defaults[i].module == c->module && timing_defaults[i].reg == c->reg)
+            return timing_defaults[i].read_us;
+    return SEESAW_READ_DELAY_US;
+}
+
+static void cal_apply(const cal_record_t *r)
+{
+    for (int i = 0; i < CAL_REGS; i++) {
+        const seesaw_timing_t *t = seesaw_timing(cal_regs[i].module, cal_regs[i].reg);
+        seesaw_set_timing(cal_regs[i].module, cal_regs[i].reg, r->read_us[i], t ? t->settle_us : 0);
+    }
+}
+
+// The table, with the calibrated read delays on top once there are some.
+static void timing_apply(void)
+{
+    timing_defaults_apply();
+    if (cal_valid) cal_apply(&cal);
+}
+
+static void keypad_pause(bool pause);
+
+static bool cal_answer_ok(const cal_reg_t *c, const uint8_t *buf, const uint8_t *ref)
+{
+    switch (c->check) {
+        case CHECK_HW_ID: return buf[0] == 0x55;
+        case CHECK_SAME:  return memcmp(buf, ref, c->len) == 0;
+    }
+    return false;
+}
+
+static bool cal_try(uint8_t addr, const cal_reg_t *c, uint16_t delay_us, const uint8_t *ref)
+{
+    uint8_t buf[CAL_LEN_MAX];
+
+    for (int i = 0; i < CAL_TRIES; i++) {
+        if (!seesaw_read_delay(addr, c->module, c->reg, buf, c->len, delay_us)) return false;
+        if (!cal_answer_ok(c, buf, ref)) return false;
+    }
+    return true;
+}
+
+// Shortest delay that gives CAL_TRIES good reads in a row, by bisection
+// between CAL_MIN_US and twice the default. 0 if even that fails.
+static uint16_t cal_measure(uint8_t addr, const cal_reg_t *c)
+{
+    uint16_t hi = (uint16_t)(2 * default_read_us(c));
+    uint16_t lo = CAL_MIN_US;
+    uint8_t ref[CAL_LEN_MAX];
+
+    if (!seesaw_read_delay(addr, c->module, c->reg, ref, c->len, hi)) return 0;
+    if (!cal_try(addr, c, hi, ref)) return 0;
+    if (cal_try(addr, c, lo, ref)) return lo;
+
+    while (hi - lo > CAL_STEP_US) {
+        uint16_t mid = (uint16_t)((lo + hi) / 2);
+        if (cal_try(addr, c, mid, ref)) hi = mid;
+        else lo = mid;
+    }
+    return hi;
+}
+
+bool neotrellis_calibrate(void)
+{
+    cal_record_t r = { 0 };
+    uint32_t version = 0;
+    bool ok = true;
+
+    if (!neotrellis_status(NULL, &version)) return false;
+    r.version = version;
+
+    // FIFO reads keep the seesaw's scan loop busy and would skew the search
+    keypad_pause(true);
+    for (int i = 0; i < CAL_REGS; i++) {
+        uint16_t worst = 0;
+        for (int t = 0; t < NEOTRELLIS_TILES; t++) {
+            uint16_t us = cal_measure(NEOTRELLIS_TILE_ADDR(t), &cal_regs[i]);
+            if (!us) { ok = false; worst = default_read_us(&cal_regs[i]); break; }
+            if (us > worst) worst = us;
+        }
+        // margin for temperature and a busier scan loop
+        r.read_us[i] = (uint16_t)(worst + worst / 4 + CAL_STEP_US);
+    }
+    keypad_pause(false);
+    if (!ok) {
+        printf("[neo] calibration failed, keeping defaults\n");
+        return false;
+    }
+
+    cal = r;
+    cal_valid = true;
+    cal_apply(&cal);
+    if (!persist_save(PERSIST_SEESAW_TIMING, &cal, sizeof cal)) printf("[neo] calibration not saved\n");
+    neotrellis_timing_print();
+    return true;
+}
+
+bool neotrellis_timing_init(bool calibrate)
+{
+    cal_record_t r;
+    uint32_t version = 0;
+
+    neotrellis_status(NULL, &version);
+    if (persist_load(PERSIST_SEESAW_TIMING, &r, sizeof r) && r.version == version) {
+        cal = r;
+        cal_valid = true;
+        cal_apply(&cal);
+        printf("[neo] seesaw timing loaded from flash\n");
+        return true;
+    }
+    return calibrate ? neotrellis_calibrate() : false;
+}
+
+void neotrellis_timing_print(void)
+{
+    printf("[neo] seesaw timing (%s):\n", cal_valid ? "calibrated" : "defaults");
+    for (int i = 0; i < CAL_REGS; i++) {
+        const seesaw_timing_t *t = seesaw_timing(cal_regs[i].module, cal_regs[i].reg);
+        printf("  %02X:%02X read %u us (default %u)\n", cal_regs[i].module, cal_regs[i].reg,
+               t ? t->read_us : SEESAW_READ_DELAY_US, default_read_us(&cal_regs[i]));
+    }
+}
+
+// Puts each tile on whichever bus it answers on, first bus first.
+void neotrellis_assign_buses(void) {
+    for (int t = 0; t < NEOTRELLIS_TILES; t++) {
+        uint8_t addr = NEOTRELLIS_TILE_ADDR(t);
+        for (uint8_t b = 0; b < SEESAW_BUSES; b++) {
+            seesaw_bus_t *bus = seesaw_bus(b);
+            if (bus && seesaw_probe(bus, addr)) {
+                seesaw_bus_assign(addr, bus);
+                printf("[neo] tile %d @0x%02X on bus %u\n", t, addr, b);
+                break;
+            }
+        }
+    }
+}
+
+// === Cached topology ===
+// What the last full scan found: every address that answered on each bus,
+// with HW_ID and firmware version for the tiles, plus each bus's
+// negotiated rate. A boot that finds exactly that again skips the scan,
+// the bus probing and the speed negotiation.
+#define TOPO_MAX_DEVICES    16
+
+typedef struct {
+    uint8_t  addr;
+    uint8_t  bus;
+    uint8_t  hw_id;             // tiles only, else 0
+    uint8_t  rsvd;
+    uint32_t version;
+} topo_dev_t;
+
+typedef struct {
+    uint8_t    count;
+    uint8_t    rsvd[3];
+    uint32_t   speed[SEESAW_BUSES];
+    topo_dev_t dev[TOPO_MAX_DEVICES];
+} topo_record_t;
+
+static topo_record_t topo;
+static bool topo_cached = false;
+
+static bool is_tile_addr(uint8_t addr)
+{
+    return addr >= NEOTRELLIS_ADDR && addr < NEOTRELLIS_ADDR + NEOTRELLIS_TILES;
+}
+
+static bool tile_identity(uint8_t addr, uint8_t *hw_id, uint32_t *version)
+{
+    uint8_t v[4];
+
+    if (!seesaw_read(addr, SEESAW_STATUS_BASE, SEESAW_STATUS_HW_ID, hw_id, 1)) return false;
+    if (!seesaw_read(addr, SEESAW_STATUS_BASE, SEESAW_STATUS_VERSION, v, 4)) return false;
+    *version = ((uint32_t)v[0] << 24) | ((uint32_t)v[1] << 16) | ((uint32_t)v[2] << 8) | v[3];
+    return true;
+}
+
+// Routes and retunes from the cache, then checks every device answers as
+// recorded. Any difference means a full scan.
+static bool topology_verify(const topo_record_t *r)
+{
+    int tiles = 0;
+
+    if (r->count > TOPO_MAX_DEVICES) return false;
+    for (int i = 0; i < r->count; i++) {
+        const topo_dev_t *d = &r->dev[i];
+        seesaw_bus_t *bus = seesaw_bus(d->bus);
+        if (!bus) return false;
+
+        if (is_tile_addr(d->addr)) {
+            uint8_t id = 0;
+            uint32_t version = 0;
+            seesaw_bus_assign(d->addr, bus);
+            if (!tile_identity(d->addr, &id, &version)) return false;
+            if (id != d->hw_id || version != d->version) return false;
+            tiles++;
+        } else if (!seesaw_probe(bus, d->addr)) {
+            return false;
+        }
+    }
+    if (tiles != NEOTRELLIS_TILES) return false;
+
+    for (uint8_t b = 0; b < SEESAW_BUSES; b++)
+        if (seesaw_bus(b) && r->speed[b]) seesaw_bus_set_speed(seesaw_bus(b), r->speed[b]);
+    return true;
+}
+
+// Every address on every bus, through the engine.
+static void topology_scan(void)
+{
+    topo = (topo_record_t){ 0 };
+
+    for (uint8_t b = 0; b < SEESAW_BUSES; b++) {
+        seesaw_bus_t *bus = seesaw_bus(b);
+        if (!bus) continue;
+        printf("I2C scan, bus %u:\n", b);
+
+        for (uint8_t a = 0x08; a <= 0x77; a++) {
+            if (!seesaw_probe(bus, a)) continue;
+            printf("  Found 0x%02X\n", a);
+            if (topo.count == TOPO_MAX_DEVICES) continue;
+
+            topo_dev_t *d = &topo.dev[topo.count++];
+            d->addr = a;
+            d->bus = b;
+            if (is_tile_addr(a)) {
+                seesaw_bus_assign(a, bus);
+                tile_identity(a, &d->hw_id, &d->version);
+            }
+        }
+    }
+}
+
+bool neotrellis_topology_init(bool rescan)
+{
+    topo_record_t r;
+
+    timing_apply();
+    if (!rescan && persist_load(PERSIST_TOPOLOGY, &r, sizeof r) && topology_verify(&r)) {
+        topo = r;
+        topo_cached = true;
+        printf("[neo] topology from flash: %u device(s), scan skipped\n", topo.count);
+        return true;
+    }
+
+    topology_scan();
+    neotrellis_assign_buses();
+    topo_cached = false;
+    return false;
+}
+
+void neotrellis_topology_save(void)
+{
+    for (uint8_t b = 0; b < SEESAW_BUSES; b++)
+        topo.speed[b] = seesaw_bus(b) ? seesaw_bus_speed(seesaw_bus(b)) : 0;
+    if (!persist_save(PERSIST_TOPOLOGY, &topo, sizeof topo)) printf("[neo] topology not saved\n");
+}
+
+bool neotrellis_topology_cached(void)
+{
+    return topo_cached;
+}
+
+// === Bus speed negotiation ===
+// Each bus steps up through the candidate rates and keeps the fastest one
+// that passes VERIFY_ROUNDS of: a pseudo-random NeoPixel buffer written and
+// read back with matching checksums, HW_ID and VERSION reads that match
+// the 100 kHz reference, sane KEYPAD_COUNT reads, and no retries or
+// recoveries on the bus. The buffer is written without SHOW, and the
+// framebuffer is marked dirty afterwards, so nothing visible changes.
+static const uint32_t bus_speeds[] = { 400000, 700000, 1000000 };
+#define BUS_SPEED_SAFE      100000
+#define VERIFY_ROUNDS       16
+#define VERIFY_CHUNK        24      // BUF bytes per transaction, under the seesaw's 32
+#define BENCH_MS            100
+
+static bool bus_readback = false;   // whether this firmware returns BUF contents
+static uint32_t bus_ref_version;
+
+static void fb_init(void);
+
+static uint16_t crc16(const uint8_t *p, int n)
+{
+    uint16_t c = 0xFFFF;
+
+    while (n--) {
+        c ^= (uint16_t)(*p++ << 8);
+        for (int k = 0; k < 8; k++) c = (uint16_t)((c & 0x8000) ? (c << 1) ^ 0x1021 : c << 1);
+    }
+    return c;
+}
+
+static bool buf_write(uint8_t addr, uint16_t off, const uint8_t *data, uint16_t len)
+{
+    uint8_t be[2] = { (uint8_t)(off >> 8), (uint8_t)off };
+    return seesaw_write_sg(addr, SEESAW_NEOPIXEL_BASE, NEOPIXEL_BUF, be, 2, data, len);
+}
+
+static bool buf_read(uint8_t addr, uint16_t off, uint8_t *data, uint16_t len)
+{
+    uint8_t be[2] = { (uint8_t)(off >> 8), (uint8_t)off };
+    seesaw_xfer_t x = {
+        .addr = addr, .module = SEESAW_NEOPIXEL_BASE, .reg = NEOPIXEL_BUF,
+        .read = true, .pre = be, .pre_len = 2, .in = data, .len = len,
+    };
+    return seesaw_transfer(&x);
+}
+
+// Writes a pattern into the tile's buffer and reads it back; true if the
+// checksums agree.
+static bool buf_roundtrip(uint8_t addr, uint32_t *seed)
+{
+    uint8_t out[NEOTRELLIS_TILE_BYTES], in[NEOTRELLIS_TILE_BYTES];
+
+    for (int i = 0; i < NEOTRELLIS_TILE_BYTES; i++) {
+        *seed ^= *seed << 13;
+        *seed ^= *seed >> 17;
+        *seed ^= *seed << 5;
+        out[i] = (uint8_t)*seed;
+    }
+    for (uint16_t off = 0; off < NEOTRELLIS_TILE_BYTES; off += VERIFY_CHUNK) {
+        if (!buf_write(addr, off, out + off, VERIFY_CHUNK)) return false;
+        if (!buf_read(addr, off, in + off, VERIFY_CHUNK)) return false;
+    }
+    return crc16(out, NEOTRELLIS_TILE_BYTES) == crc16(in, NEOTRELLIS_TILE_BYTES);
+}
+
+static bool link_ok(uint8_t addr, uint32_t *seed)
+{
+    uint8_t id = 0, count = 0xFF;
+    uint32_t version = 0;
+    uint8_t v[4];
+
+    if (!seesaw_read(addr, SEESAW_STATUS_BASE, SEESAW_STATUS_HW_ID, &id, 1) || id != 0x55) return false;
+    if (!seesaw_read(addr, SEESAW_STATUS_BASE, SEESAW_STATUS_VERSION, v, 4)) return false;
+    version = ((uint32_t)v[0] << 24) | ((uint32_t)v[1] << 16) | ((uint32_t)v[2] << 8) | v[3];
+    if (version != bus_ref_version) return false;
+    if (!seesaw_read(addr, SEESAW_KEYPAD_BASE, KEYPAD_COUNT, &count, 1) || count > 32) return false;
+    return !bus_readback || buf_roundtrip(addr, seed);
+}
+
+static bool bus_stable(seesaw_bus_t *bus)
+{
+    uint32_t faults = seesaw_bus_faults(bus);
+    uint32_t seed = 0x2545F491u;
+
+    for (int r = 0; r < VERIFY_ROUNDS; r++)
+        for (int t = 0; t < NEOTRELLIS_TILES; t++) {
+            uint8_t addr = NEOTRELLIS_TILE_ADDR(t);
+            if (seesaw_bus_for(addr) != bus) continue;
+            if (!link_ok(addr, &seed)) return false;
+        }
+    return seesaw_bus_faults(bus) == faults;
+}
+
+static bool bus_has_tiles(seesaw_bus_t *bus)
+{
+    for (int t = 0; t < NEOTRELLIS_TILES; t++)
+        if (seesaw_bus_for(NEOTRELLIS_TILE_ADDR(t)) == bus) return true;
+    return false;
+}
+
+uint32_t neotrellis_negotiate_speed(void)
+{
+    uint32_t slowest = 0;
+
+    for (uint8_t b = 0; b < SEESAW_BUSES; b++) {
+        seesaw_bus_t *bus = seesaw_bus(b);
+        if (!bus || !bus_has_tiles(bus)) continue;
+
+        // reference answers at a rate every seesaw handles
+        seesaw_bus_set_speed(bus, BUS_SPEED_SAFE);
+        uint8_t addr = 0;
+        for (int t = 0; t < NEOTRELLIS_TILES && !addr; t++)
+            if (seesaw_bus_for(NEOTRELLIS_TILE_ADDR(t)) == bus) addr = NEOTRELLIS_TILE_ADDR(t);
+        uint8_t v[4] = { 0 };
+        seesaw_read(addr, SEESAW_STATUS_BASE, SEESAW_STATUS_VERSION, v, 4);
+        bus_ref_version = ((uint32_t)v[0] << 24) | ((uint32_t)v[1] << 16) | ((uint32_t)v[2] << 8) | v[3];
+        uint32_t seed = 1;
+        bus_readback = buf_roundtrip(addr, &seed);
+
+        uint32_t best = BUS_SPEED_SAFE;
+        for (int i = 0; i < (int)count_of(bus_speeds); i++) {
+            uint32_t actual = seesaw_bus_set_speed(bus, bus_speeds[i]);
+            bool ok = bus_stable(bus);
+            printf("[neo] bus %u @ %lu Hz (actual %lu): %s\n", b,
+                   (unsigned long)bus_speeds[i], (unsigned long)actual, ok ? "stable" : "FAILED");
+            if (!ok) break;
+            best = bus_speeds[i];
+        }
+        seesaw_bus_set_speed(bus, best);
+        printf("[neo] bus %u runs at %lu Hz (buffer read-back %s)\n", b, (unsigned long)best,
+               bus_readback ? "verified" : "unsupported, status reads only");
+        if (!slowest || best < slowest) slowest = best;
+    }
+    fb_init();                      // the buffers now hold test patterns
+    return slowest;
+}
+
+// Full-tile LED frames (BUF writes + SHOW) and keypad status polls, back
+// to back for BENCH_MS each, at every candidate rate. Frames are black.
+// The polls read KEYPAD_COUNT, not the FIFO, so no key edge is lost; the
+// keypad scan is paused meanwhile and drains every tile afterwards.
+void neotrellis_bus_benchmark(void)
+{
+    static const uint8_t black[VERIFY_CHUNK] = { 0 };
+    static const uint8_t zero = 0;
+    bool animating = anim_enabled();
+
+    anim_enable(false);
+    keypad_pause(true);
+
+    for (uint8_t b = 0; b < SEESAW_BUSES; b++) {
+        seesaw_bus_t *bus = seesaw_bus(b);
+        if (!bus || !bus_has_tiles(bus)) continue;
+        uint32_t keep = seesaw_bus_speed(bus);
+
+        for (int i = -1; i < (int)count_of(bus_speeds); i++) {
+            uint32_t hz = i < 0 ? BUS_SPEED_SAFE : bus_speeds[i];
+            seesaw_bus_set_speed(bus, hz);
+
+            uint32_t frames = 0, led_bytes = 0, polls = 0, kp_bytes = 0;
+            uint32_t faults = seesaw_bus_faults(bus);
+            uint32_t t0 = time_us_32();
+            while (time_us_32() - t0 < BENCH_MS * 1000u) {
+                for (int t = 0; t < NEOTRELLIS_TILES; t++) {
+                    uint8_t addr = NEOTRELLIS_TILE_ADDR(t);
+                    if (seesaw_bus_for(addr) != bus) continue;
+                    for (uint16_t off = 0; off < NEOTRELLIS_TILE_BYTES; off += VERIFY_CHUNK) {
+                        buf_write(addr, off, black, VERIFY_CHUNK);
+                        led_bytes += 1 + 2 + 2 + VERIFY_CHUNK;
+                    }
+                    seesaw_write(addr, SEESAW_NEOPIXEL_BASE, NEOPIXEL_SHOW, &zero, 0);
+                    led_bytes += 1 + 2;
+                }
+                frames++;
+            }
+            uint32_t led_us = time_us_32() - t0;
+
+            t0 = time_us_32();
+            while (time_us_32() - t0 < BENCH_MS * 1000u) {
+                uint8_t count;
+                for (int t = 0; t < NEOTRELLIS_TILES; t++) {
+                    uint8_t addr = NEOTRELLIS_TILE_ADDR(t);
+                    if (seesaw_bus_for(addr) != bus) continue;
+                    seesaw_read(addr, SEESAW_KEYPAD_BASE, KEYPAD_COUNT, &count, 1);
+                    kp_bytes += 1 + 2 + 1 + 1;
+                    polls++;
+                }
+            }
+            uint32_t kp_us = time_us_32() - t0;
+
+            printf("[neo] bus %u @ %7lu Hz: LED %4lu frames/s %6lu B/s, keypad %5lu polls/s %6lu B/s, %lu faults\n",
+                   b, (unsigned long)hz,
+                   (unsigned long)((uint64_t)frames * 1000000u / led_us),
+                   (unsigned long)((uint64_t)led_bytes * 1000000u / led_us),
+                   (unsigned long)((uint64_t)polls * 1000000u / kp_us),
+                   (unsigned long)((uint64_t)kp_bytes * 1000000u / kp_us),
+                   (unsigned long)(seesaw_bus_faults(bus) - faults));
+        }
+        seesaw_bus_set_speed(bus, keep);
+    }
+    keypad_pause(false);
+    fb_init();
+    anim_enable(animating);
+}
 
 bool neotrellis_reset(void) {
     uint8_t dum = 0xFF;
-    bool ok = seesaw_write(NEOTRELLIS_ADDR, SEESAW_STATUS_BASE, SEESAW_STATUS_SWRST, &dum, 1);
-    sleep_ms(2);                 
+    bool ok = true;
+
+    timing_apply();
+    // the SWRST settle time holds off the next transaction to each tile
+    for (int t = 0; t < NEOTRELLIS_TILES; t++)
+        ok &= seesaw_write(NEOTRELLIS_TILE_ADDR(t), SEESAW_STATUS_BASE, SEESAW_STATUS_SWRST, &dum, 1);
     return ok;
 }
 
@@ -61,186 +571,263 @@ bool neotrellis_status(uint8_t *hw_id, uint32_t *version) {
     return ok;
 }
 
-bool neotrellis_wait_ready(uint32_t timeout_ms) {
-    absolute_time_t dl = make_timeout_time_ms(timeout_ms);
+static bool tile_wait_ready(uint8_t addr, absolute_time_t dl) {
     uint8_t id;
     while (!time_reached(dl)) {
-        if (seesaw_read(NEOTRELLIS_ADDR, SEESAW_STATUS_BASE, SEESAW_STATUS_HW_ID, &id, 1)) {
+        if (seesaw_read(addr, SEESAW_STATUS_BASE, SEESAW_STATUS_HW_ID, &id, 1)) {
             if (id == 0x55) return true;   
         }
-        sleep_ms(5);
+        sleep_ms(1);
     }
     return false;
 }
 
-bool neopixel_begin(uint8_t internal_pin) {
-    sleep_ms(100);                             
+bool neotrellis_wait_ready(uint32_t timeout_ms) {
+    absolute_time_t dl = make_timeout_time_ms(timeout_ms);
+    for (int t = 0; t < NEOTRELLIS_TILES; t++)
+        if (!tile_wait_ready(NEOTRELLIS_TILE_ADDR(t), dl)) return false;
+    return true;
+}
 
+static bool tile_begin(uint8_t addr, uint8_t internal_pin) {
     uint8_t hw_id1 = 0;
-    if (!seesaw_read(NEOTRELLIS_ADDR, SEESAW_STATUS_BASE, SEESAW_STATUS_HW_ID, &hw_id1, 1)) {
-        printf("Status check #1 failed\n");
+    if (!seesaw_read(addr, SEESAW_STATUS_BASE, SEESAW_STATUS_HW_ID, &hw_id1, 1)) {
+        printf("Status check #1 failed @0x%02X\n", addr);
         return false;
     }
-    printf("Status check #1: HW_ID=0x%02X\n", hw_id1);
-    sleep_ms(10);
+    printf("Status check #1 @0x%02X: HW_ID=0x%02X\n", addr, hw_id1);
 
-    uint16_t len = 48;                                
-    uint8_t len_be[2] = { 0x00, 0x30 };
-    if (!seesaw_write(NEOTRELLIS_ADDR, SEESAW_NEOPIXEL_BASE, NEOPIXEL_BUF_LENGTH, len_be, 2)) {
+    uint16_t len = NEOTRELLIS_TILE_BYTES;                                
+    uint8_t len_be[2] = { 0x00, NEOTRELLIS_TILE_BYTES };
+    if (!seesaw_write(addr, SEESAW_NEOPIXEL_BASE, NEOPIXEL_BUF_LENGTH, len_be, 2)) {
     printf("BUF_LENGTH write failed\n"); return false;
     } else { printf("BUF length set successfully to 0x%04X (%u)  [MSB=0x%02X LSB=0x%02X]\n", len, len, len_be[0], len_be[1]);}
-    sleep_ms(200);
 
     uint8_t speed = 0x01;  
-    if (!seesaw_write(NEOTRELLIS_ADDR, SEESAW_NEOPIXEL_BASE, NEOPIXEL_SPEED, &speed, 1)) {
+    if (!seesaw_write(addr, SEESAW_NEOPIXEL_BASE, NEOPIXEL_SPEED, &speed, 1)) {
         printf("SPEED set fail\n");
         return false;
     }
     printf("SPEED set successfully\n");
-    sleep_ms(200);
 
-    uint8_t pin =3 ;  
-    if (!seesaw_write(NEOTRELLIS_ADDR, SEESAW_NEOPIXEL_BASE, NEOPIXEL_PIN, &pin, 1))  
+    uint8_t pin = internal_pin;  
+    if (!seesaw_write(addr, SEESAW_NEOPIXEL_BASE, NEOPIXEL_PIN, &pin, 1))  
     { printf("PIN set fail\n");
     } 
     else{
         printf("PIN set succesfully to %d\n", pin);
     }
-    sleep_ms(200);
 
-    if (!neotrellis_wait_ready(300)) {
+    if (!tile_wait_ready(addr, make_timeout_time_ms(300))) {
         printf("HW_ID never became 0x55\n");
         return false;
     }
-    printf("HW_ID OK (0x55)\n");
+    printf("HW_ID OK (0x55) @0x%02X\n", addr);
+    return true;
+}
 
-    uint8_t probe_id = 0;
-    
-    bool probe_ok = neotrellis_status(&probe_id, NULL);
-    printf("Another status check @0x%02X: %s, HW_ID=0x%02X\n", NEOTRELLIS_ADDR, probe_ok ? "OK" : "FAIL", probe_id);
+bool neopixel_begin(uint8_t internal_pin) {
+    for (int t = 0; t < NEOTRELLIS_TILES; t++)
+        if (!tile_begin(NEOTRELLIS_TILE_ADDR(t), internal_pin)) return false;
+    fb_init();
 
+    printf("%d tile(s), %dx%d keys\n", NEOTRELLIS_TILES, NEOTRELLIS_GRID_W, NEOTRELLIS_GRID_H);
     return true;
 }
 
-bool neopixel_show(void) {
-    uint8_t hdr[2] = { SEESAW_NEOPIXEL_BASE, NEOPIXEL_SHOW };
-    int wrote = i2c_write_blocking(NEOTRELLIS_I2C, NEOTRELLIS_ADDR, hdr, 2, false);
-    
-    if (wrote != 2) {
-        printf("SHOW command FAILED!\n");
+#define DBG(fmt, ...)  printf("[NEO] " fmt "\n", ##__VA_ARGS__)
+
+// === Shadow framebuffer ===
+// Pixels are written here (GRB, like the seesaw buffer) and only changed
+// pixels are sent. A flush turns the dirty mask into as few NEOPIXEL_BUF
+// writes as possible, then latches them with one SHOW; it is queued on the
+// seesaw engine and never waits for the bus. Runs point straight into fb;
+// a pixel changed mid-flight is dirty again and goes out with the next flush.
+
+#define FB_RUN_PIXELS   9       // 27 bytes: a BUF write carries at most 28
+#define FB_GAP_PIXELS   1       // resending one clean pixel (3 bytes) beats a
+                                // new write's addr + module/reg + offset (5)
+#define FB_MAX_RUNS     8
+
+// Kept per tile so runs are contiguous in the tile's own buffer and each
+// tile's writes coalesce behind one SHOW.
+static uint8_t fb[NEOTRELLIS_TILES][NEOTRELLIS_TILE_BYTES];
+static volatile uint16_t fb_dirty[NEOTRELLIS_TILES];
+static volatile bool fb_in_flight[NEOTRELLIS_TILES];
+static volatile bool fb_flush_wanted[NEOTRELLIS_TILES];
+
+static seesaw_xfer_t fb_run[NEOTRELLIS_TILES][FB_MAX_RUNS];
+static uint8_t fb_offset[NEOTRELLIS_TILES][FB_MAX_RUNS][2];
+static seesaw_xfer_t fb_show[NEOTRELLIS_TILES];
+
+static uint32_t fb_flushes = 0;
+static uint32_t fb_last_bytes = 0, fb_last_xfers = 0;
+static uint32_t fb_total_bytes = 0, fb_total_xfers = 0;
+
+typedef struct {
+    uint32_t kp_reads;
+    uint32_t kp_events;
+    uint32_t kp_bus_us;
+    uint32_t led_xfers;
+    uint32_t led_bus_us;
+} tile_stats_t;
+
+static tile_stats_t tile_stats[NEOTRELLIS_TILES];
+
+static void fb_init(void)
+{
+    // seesaw contents are unknown at boot
+    for (int t = 0; t < NEOTRELLIS_TILES; t++) fb_dirty[t] = 0xFFFF;
+}
+
+// Core 1 renders animation frames into fb while core 0 flushes it, so the
+// dirty masks are under a hardware spinlock rather than just IRQs off.
+static void fb_mark(int tile, uint16_t mask)
+{
+    spin_lock_t *lock = cores_lock(CORES_LOCK_FB);
+    uint32_t irq = spin_lock_blocking(lock);
+    fb_dirty[tile] |= mask;
+    spin_unlock(lock, irq);
+}
+
+static void fb_run_done(seesaw_xfer_t *x)
+{
+    uint32_t u = (uint32_t)(uintptr_t)x->user;
+    int tile = (int)(u >> 16);
+
+    tile_stats[tile].led_xfers++;
+    tile_stats[tile].led_bus_us += time_us_32() - x->start_us;
+    if (!x->ok) fb_mark(tile, (uint16_t)u);     // resend next flush
+}
+
+static bool tile_flush(int t);
+
+static void fb_show_done(seesaw_xfer_t *x)
+{
+    int tile = (int)(uintptr_t)x->user;
+
+    tile_stats[tile].led_xfers++;
+    tile_stats[tile].led_bus_us += time_us_32() - x->start_us;
+    fb_in_flight[tile] = false;
+    if (fb_flush_wanted[tile]) tile_flush(tile);
+}
+
+static bool tile_flush(int t) {
+    spin_lock_t *lock = cores_lock(CORES_LOCK_FB);
+    uint32_t irq = spin_lock_blocking(lock);
+    if (fb_in_flight[t]) {
+        fb_flush_wanted[t] = true;      // picked up when the SHOW completes
+        spin_unlock(lock, irq);
         return false;
     }
-    
-    sleep_ms(10);  
-    return true;
-}
+    uint16_t d = fb_dirty[t];
+    fb_dirty[t] = 0;
+    fb_flush_wanted[t] = false;
+    fb_in_flight[t] = (d != 0);
+    spin_unlock(lock, irq);
 
-#define DBG(fmt, ...)  printf("[NEO] " fmt "\n", ##__VA_ARGS__)
+    if (!d) return false;
 
-static bool neopixel_buf_write(uint16_t start, const uint8_t *data, size_t len) {
-    while (len) {
-        size_t n = len > 28 ? 28 : len;  
-        uint8_t payload[2 + 28];
-        
-        payload[0] = (uint8_t)(start >> 8) & 0xFF;
-        payload[1] = (uint8_t)(start & 0xFF);
-        memcpy(&payload[2], data, n);  
-        
-        size_t total = 2 + n;  
-        
-        bool ok = seesaw_write_buf(NEOTRELLIS_ADDR, SEESAW_NEOPIXEL_BASE, 
-                                   NEOPIXEL_BUF, payload, total);
-        if (!ok) {
-            return false;
+    uint8_t addr = NEOTRELLIS_TILE_ADDR(t);
+    int n = 0;
+    uint32_t bytes = 0;
+    int p = 0;
+    while (p < NEOTRELLIS_TILE_KEYS) {
+        if (!(d & (1u << p))) { p++; continue; }
+
+        int start = p, last = p;
+        for (int q = p + 1; q < NEOTRELLIS_TILE_KEYS && q - start < FB_RUN_PIXELS; q++) {
+            if (d & (1u << q)) last = q;
+            else if (q - last > FB_GAP_PIXELS) break;
         }
-        
-        start += (uint16_t)n;
-        data  += n;
-        len   -= n;
+
+        uint16_t off = (uint16_t)(start * 3);
+        uint16_t len = (uint16_t)((last - start + 1) * 3);
+        uint32_t mask = ((1u << (last + 1)) - 1) & ~((1u << start) - 1);
+        fb_offset[t][n][0] = (uint8_t)(off >> 8);
+        fb_offset[t][n][1] = (uint8_t)(off & 0xFF);
+        fb_run[t][n] = (seesaw_xfer_t){
+            .addr = addr, .module = SEESAW_NEOPIXEL_BASE, .reg = NEOPIXEL_BUF,
+            .prio = SEESAW_PRIO_LED, .pre = fb_offset[t][n], .pre_len = 2,
+            .out = &fb[t][off], .len = len,
+            .done = fb_run_done,
+            .user = (void *)(uintptr_t)(((uint32_t)t << 16) | mask),
+        };
+        seesaw_submit(&fb_run[t][n]);
+        bytes += seesaw_xfer_cost(&fb_run[t][n]);
+        n++;
+        p = last + 1;
     }
-    
+
+    fb_show[t] = (seesaw_xfer_t){
+        .addr = addr, .module = SEESAW_NEOPIXEL_BASE, .reg = NEOPIXEL_SHOW,
+        .prio = SEESAW_PRIO_LED, .done = fb_show_done,
+        .user = (void *)(uintptr_t)t,
+    };
+    seesaw_submit(&fb_show[t]);
+    bytes += seesaw_xfer_cost(&fb_show[t]);
+    n++;
+
+    fb_last_bytes += bytes;
+    fb_last_xfers += (uint32_t)n;
     return true;
 }
 
-bool neopixel_set_one_and_show(int idx, uint8_t r, uint8_t g, uint8_t b) {
-    if ((unsigned)idx >= 16) { printf("idx out of range\n"); return false; }
+bool neopixel_show(void) {
+    uint32_t bytes0 = fb_last_bytes, xfers0 = fb_last_xfers;
+    bool any = false;
 
-    uint16_t start = (uint16_t)(idx * 3);
-    uint8_t  grb[3] = { g, r, b };           
-    
-    uint8_t zeros[48] = {0};
-    neopixel_buf_write(0, zeros, 28);   
-    sleep_ms(2);
-    neopixel_buf_write(28, zeros + 28, 20);  
-    sleep_ms(2);
-    neopixel_show();
-    
-    if (!neopixel_buf_write(start, grb, 3)) {
-        printf("BUF write failed (idx=%d start=%u)\n", idx, start);
-        return false;
-    }
+    fb_last_bytes = fb_last_xfers = 0;
+    for (int t = 0; t < NEOTRELLIS_TILES; t++) any |= tile_flush(t);
 
-    sleep_us(300);   
-    int ok = neopixel_show();                        
-    return ok;
+    if (any) {
+        fb_flushes++;
+        fb_total_bytes += fb_last_bytes;
+        fb_total_xfers += fb_last_xfers;
+    } else {
+        fb_last_bytes = bytes0;         // keep reporting the last real flush
+        fb_last_xfers = xfers0;
+    }
+    return true;
 }
 
-bool neopixel_fill_all_and_show(uint8_t r, uint8_t g, uint8_t b) {
-    uint8_t frame[48];
-    for (int i = 0; i < 16; ++i) {
-        frame[3 * i + 0] = g;
-        frame[3 * i + 1] = r;
-        frame[3 * i + 2] = b;
-    }
-    if (!neopixel_buf_write(0, frame, 48)) {
-        printf("neopixel_fill_all_and_show: buf_write failed\n");
-        return false;
-    }
-    sleep_us(300);
-    int ok = neopixel_show();
-    return ok;
+// Writes one pixel into the framebuffer; only a change marks it dirty.
+bool neopixel_set_pixel(int idx, uint8_t r, uint8_t g, uint8_t b) {
+    if ((unsigned)idx >= NEOTRELLIS_LED_COUNT) return false;
+
+    int t = neotrellis_key_tile(idx);
+    int l = neotrellis_key_local(idx);
+    uint8_t *px = &fb[t][3 * l];
+    if (px[0] == g && px[1] == r && px[2] == b) return true;
+    px[0] = g;
+    px[1] = r;
+    px[2] = b;
+    fb_mark(t, (uint16_t)(1u << l));
+    return true;
 }
 
-static void color_wheel(uint8_t pos, uint8_t *r, uint8_t *g, uint8_t *b) {
-    if (pos < 85) {
-        *r = 255 - pos * 3;
-        *g = pos * 3;
-        *b = 0;
-    } else if (pos < 170) {
-        pos -= 85;
-        *r = 0;
-        *g = 255 - pos * 3;
-        *b = pos * 3;
-    } else {
-        pos -= 170;
-        *r = pos * 3;
-        *g = 0;
-        *b = 255 - pos * 3;
-    }
-}
-
-void neotrellis_rainbow_startup(void) {
-    uint8_t frame[48];        
-    const int frames = 32;    
-    const int delay_ms = 60;  
-
-    for (int step = 0; step < frames; ++step) {
-        for (int i = 0; i < 16; ++i) {
-            uint8_t r, g, b;
-            uint8_t hue = (i * 16 + step * 8) & 0xFF;
-            color_wheel(hue, &r, &g, &b);
-            frame[3 * i + 0] = g;
-            frame[3 * i + 1] = r;
-            frame[3 * i + 2] = b;
-        }
+bool neopixel_set_one_and_show(int idx, uint8_t r, uint8_t g, uint8_t b) {
+    if ((unsigned)idx >= NEOTRELLIS_LED_COUNT) { printf("idx out of range\n"); return false; }
 
-        neopixel_buf_write(0, frame, 48);
-        sleep_us(300);
-        neopixel_show();
-        sleep_ms(delay_ms);
+    for (int i = 0; i < NEOTRELLIS_LED_COUNT; i++) {
+        if (i == idx) neopixel_set_pixel(i, r, g, b);
+        else neopixel_set_pixel(i, 0, 0, 0);
     }
+    return neopixel_show();
+}
 
-    neopixel_fill_all_and_show(0, 0, 0);
+bool neopixel_fill_all_and_show(uint8_t r, uint8_t g, uint8_t b) {
+    for (int i = 0; i < NEOTRELLIS_LED_COUNT; ++i) neopixel_set_pixel(i, r, g, b);
+    return neopixel_show();
+}
+
+void neopixel_fb_print(void)
+{
+    printf("[NEO] %lu flushes, last %lu bytes in %lu transactions, avg %lu bytes / %lu.%02lu transactions\n",
+           (unsigned long)fb_flushes, (unsigned long)fb_last_bytes, (unsigned long)fb_last_xfers,
+           (unsigned long)(fb_flushes ? fb_total_bytes / fb_flushes : 0),
+           (unsigned long)(fb_flushes ? fb_total_xfers / fb_flushes : 0),
+           (unsigned long)(fb_flushes ? (fb_total_xfers * 100 / fb_flushes) % 100 : 0));
 }
 
 static const uint8_t neotrellis_key_lut[16] = {
@@ -250,7 +837,19 @@ static const uint8_t neotrellis_key_lut[16] = {
     24, 25, 26, 27
 };
 
-static bool set_keypad_event(uint8_t key, uint8_t edge, bool enable) {
+// seesaw key number (row * 8 + col) -> our 0..15 index, -1 = not a key
+static const int8_t neotrellis_key_index[64] = {
+     0,  1,  2,  3, -1, -1, -1, -1,
+     4,  5,  6,  7, -1, -1, -1, -1,
+     8,  9, 10, 11, -1, -1, -1, -1,
+    12, 13, 14, 15, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1,
+};
+
+static bool set_keypad_event(uint8_t addr, uint8_t key, uint8_t edge, bool enable) {
     uint8_t ks = 0;
     if (enable) {
         ks |= 0x01;                   
@@ -259,38 +858,44 @@ static bool set_keypad_event(uint8_t key, uint8_t edge, bool enable) {
 
     uint8_t cmd[2] = { key, ks };
 
-    printf("[neo] enable %s: key=%d cfg=0x%02x\n",
+    printf("[neo] enable %s @0x%02X: key=%d cfg=0x%02x\n",
            (edge == SEESAW_KEYPAD_EDGE_RISING) ? "rising" : "falling",
-           key, ks);
+           addr, key, ks);
 
-    return seesaw_write(NEOTRELLIS_ADDR,
+    return seesaw_write(addr,
                         SEESAW_KEYPAD_BASE,
                         KEYPAD_ENABLE,
                         cmd, sizeof(cmd));
 }
 
-bool neotrellis_keypad_init(void) {
-    printf("[neo] keypad_init: start\n");
-    
+static bool tile_keypad_init(uint8_t addr) {
     uint8_t val = 0x01;
-    if (!seesaw_write(NEOTRELLIS_ADDR, SEESAW_KEYPAD_BASE, KEYPAD_INTEN, &val, 1)) {
-        printf("[neo] enableKeypadInterrupt failed\n");
+    if (!seesaw_write(addr, SEESAW_KEYPAD_BASE, KEYPAD_INTEN, &val, 1)) {
+        printf("[neo] enableKeypadInterrupt failed @0x%02X\n", addr);
         return false;
     }
 
-    for (int i = 0; i < 16; i++) {
+    for (int i = 0; i < NEOTRELLIS_TILE_KEYS; i++) {
         uint8_t key = neotrellis_key_lut[i];
         
-        if (!set_keypad_event(key, SEESAW_KEYPAD_EDGE_RISING, true)) {
+        if (!set_keypad_event(addr, key, SEESAW_KEYPAD_EDGE_RISING, true)) {
             printf("[neo] setKeypadEvent rising failed for key %d\n", key);
             return false;
         }
         
-        if (!set_keypad_event(key, SEESAW_KEYPAD_EDGE_FALLING, true)) {
+        if (!set_keypad_event(addr, key, SEESAW_KEYPAD_EDGE_FALLING, true)) {
             printf("[neo] setKeypadEvent falling failed for key %d\n", key);
             return false;
         }
     }
+    return true;
+}
+
+bool neotrellis_keypad_init(void) {
+    printf("[neo] keypad_init: start\n");
+
+    for (int t = 0; t < NEOTRELLIS_TILES; t++)
+        if (!tile_keypad_init(NEOTRELLIS_TILE_ADDR(t))) return false;
     
     printf("[neo] keypad_init OK\n");
     return true;
@@ -301,7 +906,7 @@ void set_led_for_idx(int idx, bool on)
     if (!on) {
         // Turn off LED and stop note
         neopixel_set_one_and_show(idx, 0x00, 0x00, 0x00);
-        stop_note();
+        stop_note(idx);
         printf("Button %d OFF\n", idx);
         return;
     }
@@ -409,77 +1014,300 @@ void set_led_for_idx(int idx, bool on)
     }
 }
 
-bool neotrellis_poll_buttons(int *idx_out)
+// Default key behavior: animate the key, play its note, show it on the LCD.
+// Each goes out as an event on that subsystem's own queue, so a slow LCD
+// redraw or USB print never holds up the note.
+void neotrellis_play_key(int idx, bool pressed)
 {
-    uint8_t count = 0;
-    bool found_press = false;
-    int result_idx = -1;
-    
-    if (!seesaw_read(NEOTRELLIS_ADDR, SEESAW_KEYPAD_BASE, KEYPAD_COUNT, &count, 1)) {
-        return false;
+    if (pressed) play_note(idx);
+    else stop_note(idx);
+    anim_post_key(idx, pressed);
+    LCD_post_key(idx, pressed);
+}
+
+static neotrellis_key_handler_t key_handler = neotrellis_play_key;
+
+void neotrellis_set_key_handler(neotrellis_key_handler_t fn)
+{
+    key_handler = fn ? fn : neotrellis_play_key;
+}
+
+// INT-driven keypad: the FIFO is only read after the seesaw pulls INT low,
+// plus a slow poll in case an edge is missed or INT is not wired.
+// All tiles share one wired-OR INT line, so an edge marks every tile
+// pending; each poll starts one read per bus on the next pending tile,
+// round-robin, and a tile drops out once a read comes back short of a
+// full burst.
+#define TILES_ALL   ((uint8_t)((1u << NEOTRELLIS_TILES) - 1))
+
+static volatile bool keys_pending = true;      // drain once after init
+static volatile uint8_t tiles_pending = TILES_ALL;
+static volatile uint32_t int_time_us = 0;
+static bool keypad_irq = false;
+static uint32_t last_read_ms = 0;
+static uint32_t lat_sum_us = 0, lat_max_us = 0, lat_count = 0;
+static uint32_t scan_start_us = 0, scan_sum_us = 0, scan_max_us = 0, scan_count = 0;
+static uint8_t kp_cursor = 0;
+
+static void keypad_int_callback(uint gpio, uint32_t events)
+{
+    if (gpio != NEOTRELLIS_INT) return;
+    if (!keys_pending) int_time_us = time_us_32();
+    keys_pending = true;
+    tiles_pending = TILES_ALL;
+    sched_kick();
+}
+
+void neotrellis_keypad_irq_init(void)
+{
+    gpio_init(NEOTRELLIS_INT);
+    gpio_set_dir(NEOTRELLIS_INT, GPIO_IN);
+    gpio_pull_up(NEOTRELLIS_INT);
+    gpio_set_irq_enabled_with_callback(NEOTRELLIS_INT, GPIO_IRQ_EDGE_FALL, true, keypad_int_callback);
+    keypad_irq = true;
+    int_time_us = time_us_32();
+    keys_pending = true;
+    tiles_pending = TILES_ALL;
+    printf("[neo] keypad INT on GPIO %d\n", NEOTRELLIS_INT);
+}
+
+void neotrellis_keypad_set_irq(bool on)
+{
+    keypad_irq = on;
+    int_time_us = time_us_32();
+    keys_pending = true;
+    tiles_pending = TILES_ALL;
+    lat_sum_us = lat_max_us = lat_count = 0;
+    scan_sum_us = scan_max_us = scan_count = 0;
+}
+
+bool neotrellis_keypad_irq(void)
+{
+    return keypad_irq;
+}
+
+void neotrellis_keypad_print(void)
+{
+    static uint32_t last_xfers = 0, last_ms = 0;
+    uint32_t now = to_ms_since_boot(get_absolute_time());
+    uint32_t xfers = seesaw_transactions();
+    uint32_t dt = now - last_ms;
+
+    printf("[neo] keypad %s: %lu I2C transactions/s",
+           keypad_irq ? "INT" : "polled",
+           dt ? (unsigned long)((uint64_t)(xfers - last_xfers) * 1000u / dt) : 0ul);
+    if (lat_count)
+        printf(", INT->events avg %lu us, max %lu us",
+               (unsigned long)(lat_sum_us / lat_count), (unsigned long)lat_max_us);
+    if (scan_count)
+        printf(", INT->all tiles avg %lu us, max %lu us",
+               (unsigned long)(scan_sum_us / scan_count), (unsigned long)scan_max_us);
+    printf("\n");
+
+    for (int t = 0; t < NEOTRELLIS_TILES; t++) {
+        const tile_stats_t *ts = &tile_stats[t];
+        printf("[neo]   tile %d @0x%02X bus %u: %lu reads, %lu events, keypad bus %lu us; "
+               "%lu LED xfers, LED bus %lu us\n",
+               t, NEOTRELLIS_TILE_ADDR(t),
+               seesaw_bus_num(seesaw_bus_for(NEOTRELLIS_TILE_ADDR(t))),
+               (unsigned long)ts->kp_reads, (unsigned long)ts->kp_events,
+               (unsigned long)ts->kp_bus_us, (unsigned long)ts->led_xfers,
+               (unsigned long)ts->led_bus_us);
     }
-    
-    if (count == 0) {
-        return false;
+
+    last_xfers = xfers;
+    last_ms = now;
+}
+
+// Decodes raw FIFO bytes. The seesaw pops what it has and pads with 0xFF,
+// so one burst read needs no KEYPAD_COUNT read first.
+static int decode_events(int tile, const uint8_t *raw, int n_raw, neotrellis_event_t *ev, uint32_t now)
+{
+    int n = 0;
+
+    for (int i = 0; i < n_raw; i++) {
+        uint8_t edge = raw[i] & 0x03;
+        if (raw[i] == 0xFF) break;
+        if (edge != SEESAW_KEYPAD_EDGE_RISING && edge != SEESAW_KEYPAD_EDGE_FALLING) continue;
+
+        int8_t idx = neotrellis_key_index[raw[i] >> 2];
+        if (idx < 0) continue;
+
+        ev[n].key = (uint8_t)neotrellis_key_at(tile, idx);
+        ev[n].pressed = (edge == SEESAW_KEYPAD_EDGE_RISING);
+        ev[n].time_us = now;
+        n++;
     }
-    
-    if (count > 8) count = 8;
+    return n;
+}
 
-    for (uint8_t e = 0; e < count; e++) {
-        uint8_t evt;
-        if (!seesaw_read(NEOTRELLIS_ADDR, SEESAW_KEYPAD_BASE, KEYPAD_FIFO, &evt, 1)) {
-            continue;
-        }
-        
-        uint8_t keynum = evt >> 2;
-        uint8_t edge = evt & 0x03;
+int neotrellis_read_events(neotrellis_event_t *ev, int max)
+{
+    uint8_t raw[KEYPAD_BURST];
+    int n = 0;
 
-        if (evt == 0xFF || edge == 0) {
-            continue;
+    for (int t = 0; t < NEOTRELLIS_TILES && n < max; t++) {
+        int want = max - n;
+        if (want > KEYPAD_BURST) want = KEYPAD_BURST;
+        if (!seesaw_read(NEOTRELLIS_TILE_ADDR(t), SEESAW_KEYPAD_BASE, KEYPAD_FIFO, raw, (uint16_t)want)) {
+            return -1;
         }
+        n += decode_events(t, raw, want, ev + n, time_us_32());
+    }
+    return n;
+}
 
-        int idx = -1;
-        for (int i = 0; i < 16; i++) {
-            if (neotrellis_key_lut[i] == keynum) {
-                idx = i;
-                break;
-            }
-        }
-        if (idx < 0) {
-            continue;
-        }
+// FIFO bursts are read asynchronously, one descriptor per tile; events
+// are handed out on the first poll after a read lands, so the main loop
+// never waits on the bus.
+static uint8_t kp_raw[NEOTRELLIS_TILES][KEYPAD_BURST];
+static seesaw_xfer_t kp_xfer[NEOTRELLIS_TILES];
+static volatile uint8_t kp_landed = 0;
+static uint32_t kp_stamp[NEOTRELLIS_TILES];
 
-        if (edge == SEESAW_KEYPAD_EDGE_RISING) {
-            set_led_for_idx(idx, true);
-            
-            if (!found_press) {
-                result_idx = idx;
-                found_press = true;
-                printf("[neo] Button %d PRESSED (keynum=%u)\n", idx, keynum);
-                LCD_note(idx);
-            }
+static void keypad_read_done(seesaw_xfer_t *x)
+{
+    int t = (int)(uintptr_t)x->user;
+
+    tile_stats[t].kp_reads++;
+    tile_stats[t].kp_bus_us += time_us_32() - x->start_us;
+    kp_landed |= (uint8_t)(1u << t);
+    sched_kick();
+}
+
+static void keypad_submit(int t, uint32_t stamp)
+{
+    kp_xfer[t] = (seesaw_xfer_t){
+        .addr = NEOTRELLIS_TILE_ADDR(t), .module = SEESAW_KEYPAD_BASE, .reg = KEYPAD_FIFO,
+        .read = true, .prio = SEESAW_PRIO_KEYPAD, .in = kp_raw[t], .len = KEYPAD_BURST,
+        .done = keypad_read_done, .user = (void *)(uintptr_t)t,
+    };
+    kp_stamp[t] = stamp;
+    seesaw_submit(&kp_xfer[t]);
+}
+
+static bool kp_paused = false;
+
+// Holds off new FIFO reads and waits out the ones in flight. Resuming
+// drains every tile once, for the edges that queued up meanwhile.
+static void keypad_pause(bool pause)
+{
+    kp_paused = pause;
+    if (pause) {
+        for (int t = 0; t < NEOTRELLIS_TILES; t++)
+            while (kp_xfer[t].busy) tight_loop_contents();
+    } else {
+        keys_pending = true;
+        tiles_pending = TILES_ALL;
+    }
+}
+
+static int keypad_land(int t, neotrellis_event_t *ev)
+{
+    uint32_t now = time_us_32();
+    const seesaw_xfer_t *x = &kp_xfer[t];
+    int n = x->ok ? decode_events(t, kp_raw[t], KEYPAD_BURST, ev, kp_stamp[t] ? kp_stamp[t] : now) : 0;
+
+    // a full burst may have left more behind; a failed read retries
+    if (x->ok && kp_raw[t][KEYPAD_BURST - 1] == 0xFF) {
+        uint32_t irq = save_and_disable_interrupts();
+        tiles_pending &= (uint8_t)~(1u << t);
+        bool swept = (tiles_pending == 0);
+        restore_interrupts(irq);
+
+        if (swept && scan_start_us) {
+            uint32_t scan = now - scan_start_us;
+            scan_sum_us += scan;
+            scan_count++;
+            if (scan > scan_max_us) scan_max_us = scan;
+            scan_start_us = 0;
         }
-        else if (edge == SEESAW_KEYPAD_EDGE_FALLING) {
-            set_led_for_idx(idx, false);
-            printf("[neo] Button %d RELEASED (keynum=%u)\n", idx, keynum);
-            LCD_Clear(0x00);
+    }
+    tile_stats[t].kp_events += (uint32_t)n;
+
+    if (kp_stamp[t]) {
+        uint32_t lat = now - kp_stamp[t];
+        lat_sum_us += lat;
+        lat_count++;
+        if (lat > lat_max_us) lat_max_us = lat;
+    }
+    return n;
+}
+
+bool neotrellis_poll_buttons(int *idx_out)
+{
+    neotrellis_event_t ev[KEYPAD_BURST];
+    int result_idx = -1;
+
+    uint32_t irq = save_and_disable_interrupts();
+    uint8_t landed = kp_landed;
+    kp_landed = 0;
+    restore_interrupts(irq);
+
+    for (int t = 0; t < NEOTRELLIS_TILES; t++) {
+        if (!(landed & (1u << t))) continue;
+
+        uint32_t t0 = time_us_32();
+        int n = keypad_land(t, ev);
+        for (int e = 0; e < n; e++) {
+            key_handler(ev[e].key, ev[e].pressed);
+            if (ev[e].pressed && result_idx < 0) result_idx = ev[e].key;
         }
+        cores_load_add(CORES_LOAD_KEYPAD, time_us_32() - t0);
     }
-    
-    if (found_press && idx_out) {
+
+    // one keypad read in flight per bus
+    uint8_t bus_busy = 0;
+    bool any_busy = false;
+    for (int t = 0; t < NEOTRELLIS_TILES; t++) {
+        if (!kp_xfer[t].busy) continue;
+        bus_busy |= (uint8_t)(1u << seesaw_bus_num(kp_xfer[t].on));
+        any_busy = true;
+    }
+
+    uint32_t now = to_ms_since_boot(get_absolute_time());
+
+    // INT is level: still low means events are left over from last time
+    bool due = !keypad_irq || keys_pending || !gpio_get(NEOTRELLIS_INT) ||
+               now - last_read_ms >= KEYPAD_FALLBACK_MS;
+    if (due && !tiles_pending && !any_busy) tiles_pending = TILES_ALL;
+
+    uint32_t stamp = 0;
+    if (keypad_irq && keys_pending) {
+        stamp = int_time_us;
+        if (!scan_start_us) scan_start_us = int_time_us;
+    }
+
+    bool submitted = false;
+    for (int i = 1; i <= NEOTRELLIS_TILES && !kp_paused; i++) {
+        int t = (kp_cursor + i) % NEOTRELLIS_TILES;
+        if (!(tiles_pending & (1u << t)) || kp_xfer[t].busy || (kp_landed & (1u << t))) continue;
+
+        uint8_t bit = (uint8_t)(1u << seesaw_bus_num(seesaw_bus_for(NEOTRELLIS_TILE_ADDR(t))));
+        if (bus_busy & bit) continue;
+
+        if (!submitted) keys_pending = false;   // before the read, so a new edge re-arms
+        bus_busy |= bit;
+        keypad_submit(t, stamp);
+        kp_cursor = (uint8_t)t;
+        submitted = true;
+    }
+    if (submitted) last_read_ms = now;
+
+    if (result_idx >= 0 && idx_out) {
         *idx_out = result_idx;
         return true;
     }
-    
+
     return false;
 }
 
-void neotrellis_clear_fifo(void)
+static void tile_clear_fifo(uint8_t addr)
 {
     while (1) {
         uint8_t count = 0;
         
-        if (!seesaw_read(NEOTRELLIS_ADDR,
+        if (!seesaw_read(addr,
                          SEESAW_KEYPAD_BASE,
                          KEYPAD_COUNT,
                          &count, 1)) {
@@ -495,7 +1323,7 @@ void neotrellis_clear_fifo(void)
 
         uint8_t dump[4 * 8];      
 
-        if (!seesaw_read(NEOTRELLIS_ADDR,
+        if (!seesaw_read(addr,
                          SEESAW_KEYPAD_BASE,
                          KEYPAD_FIFO,
                          dump,
@@ -504,6 +1332,11 @@ void neotrellis_clear_fifo(void)
             return;
         }
     }
+}
+
+void neotrellis_clear_fifo(void)
+{
+    for (int t = 0; t < NEOTRELLIS_TILES; t++) tile_clear_fifo(NEOTRELLIS_TILE_ADDR(t));
 
     printf("[neo] FIFO cleared\n");
 }
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include "persist.h"
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "pico/flash.h"
+
+#define PERSIST_OFFSET  (PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE)
+#define PERSIST_MAGIC   0x54535250u     // "PRST"
+#define PERSIST_END     0xFF            // erased flash
+
+typedef struct {
+    uint8_t  id;
+    uint8_t  rsvd;
+    uint16_t len;
+    uint32_t crc;
+} record_t;
+
+static const uint8_t *const sector = (const uint8_t *)(XIP_BASE + PERSIST_OFFSET);
+static uint8_t image[FLASH_SECTOR_SIZE] __aligned(4);
+
+static uint32_t crc32(const uint8_t *p, uint32_t n)
+{
+    uint32_t c = 0xFFFFFFFFu;
+
+    while (n--) {
+        c ^= *p++;
+        for (int k = 0; k < 8; k++) c = (c >> 1) ^ (0xEDB88320u & -(c & 1));
+    }
+    return ~c;
+}
+
+static uint32_t pad4(uint32_t n)
+{
+    return (n + 3) & ~3u;
+}
+
+// Calls fn for every intact record in the sector at base; stops at the
+// first bad or missing one.
+static uint32_t walk(const uint8_t *base, bool (*fn)(const record_t *r, const uint8_t *data, void *ctx), void *ctx)
+{
+    uint32_t magic;
+    memcpy(&magic, base, 4);
+    if (magic != PERSIST_MAGIC) return 0;
+
+    uint32_t off = 8;
+    while (off + sizeof(record_t) <= FLASH_SECTOR_SIZE) {
+        record_t r;
+        memcpy(&r, base + off, sizeof r);
+        if (r.id == PERSIST_END || r.len > PERSIST_MAX_RECORD) break;
+
+        const uint8_t *data = base + off + sizeof r;
+        if (off + sizeof r + r.len > FLASH_SECTOR_SIZE || crc32(data, r.len) != r.crc) break;
+        if (!fn(&r, data, ctx)) break;
+        off += sizeof r + pad4(r.len);
+    }
+    return off;
+}
+
+typedef struct {
+    uint8_t  id;
+    void     *buf;
+    uint16_t len;
+    bool     found;
+} find_t;
+
+static bool find_one(const record_t *r, const uint8_t *data, void *ctx)
+{
+    find_t *f = ctx;
+
+    if (r->id != f->id) return true;
+    if (r->len == f->len) {
+        memcpy(f->buf, data, f->len);
+        f->found = true;
+    }
+    return false;
+}
+
+bool persist_load(uint8_t id, void *buf, uint16_t len)
+{
+    find_t f = { .id = id, .buf = buf, .len = len };
+    walk(sector, find_one, &f);
+    return f.found;
+}
+
+typedef struct {
+    uint8_t  skip;
+    uint32_t off;
+} copy_t;
+
+static bool copy_one(const record_t *r, const uint8_t *data, void *ctx)
+{
+    copy_t *c = ctx;
+
+    if (r->id != c->skip) {
+        memcpy(image + c->off, r, sizeof *r);
+        memcpy(image + c->off + sizeof *r, data, r->len);
+        c->off += sizeof *r + pad4(r->len);
+    }
+    return true;
+}
+
+static void program_sector(void *unused)
+{
+    flash_range_erase(PERSIST_OFFSET, FLASH_SECTOR_SIZE);
+    flash_range_program(PERSIST_OFFSET, image, FLASH_SECTOR_SIZE);
+}
+
+bool persist_save(uint8_t id, const void *buf, uint16_t len)
+{
+    if (id == PERSIST_END || len > PERSIST_MAX_RECORD) return false;
+
+    // rebuild the sector in RAM: every other record, then this one
+    memset(image, 0xFF, sizeof image);
+    uint32_t magic = PERSIST_MAGIC;
+    memcpy(image, &magic, 4);
+    copy_t c = { .skip = id, .off = 8 };
+    walk(sector, copy_one, &c);
+
+    if (c.off + sizeof(record_t) + len > FLASH_SECTOR_SIZE) return false;
+    record_t r = { .id = id, .rsvd = 0, .len = len, .crc = crc32(buf, len) };
+    memcpy(image + c.off, &r, sizeof r);
+    memcpy(image + c.off + sizeof r, buf, len);
+
+    // parks core 1 in RAM as well, so it can keep running from flash
+    if (flash_safe_execute(program_sector, NULL, 100) != PICO_OK) return false;
+    return memcmp(sector, image, FLASH_SECTOR_SIZE) == 0;
+}
+
+static bool print_one(const record_t *r, const uint8_t *data, void *ctx)
+{
+    printf("  id %u, %u bytes, crc %08lx\n", r->id, r->len, (unsigned long)r->crc);
+    return true;
+}
+
+void persist_print(void)
+{
+    printf("[PERSIST] sector @0x%08lx:\n", (unsigned long)PERSIST_OFFSET);
+    uint32_t used = walk(sector, print_one, NULL);
+    printf("  %lu of %u bytes used\n", (unsigned long)used, FLASH_SECTOR_SIZE);
+}
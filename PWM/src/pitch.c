@@ -0,0 +1,65 @@
+#include "pitch.h"
+#include "audio.h"
+
+// Phase increment of MIDI note 0 in Q8, for 150 MHz / 2 / 2048 = 36621.09 Hz.
+#define INC_NOTE0_Q8    245470166u
+_Static_assert(AUDIO_SYS_CLK == 150000000 && AUDIO_PWM_DIV == 2 && AUDIO_PWM_TOP == 2047,
+               "INC_NOTE0_Q8 assumes the default audio sample rate");
+
+// 2^(i/64) in Q30 for i = 0..64: one octave in 64 steps of 18.75 cents.
+// Linear interpolation between entries is good to ~0.03 cents.
+static const uint32_t octave_ratio_q30[65] = {
+    0x40000000, 0x40B268FA, 0x4166C34C, 0x421D1462,
+    0x42D561B4, 0x438FB0CB, 0x444C0740, 0x450A6ABB,
+    0x45CAE0F2, 0x468D6FAE, 0x47521CC6, 0x4818EE22,
+    0x48E1E9BA, 0x49AD1598, 0x4A7A77D4, 0x4B4A169C,
+    0x4C1BF829, 0x4CF022CA, 0x4DC69CDD, 0x4E9F6CD4,
+    0x4F7A9930, 0x50582888, 0x51382182, 0x521A8AD7,
+    0x52FF6B55, 0x53E6C9DA, 0x54D0AD5A, 0x55BD1CDB,
+    0x56AC1F75, 0x579DBC57, 0x5891FAC1, 0x5988E209,
+    0x5A82799A, 0x5B7EC8F2, 0x5C7DD7A4, 0x5D7FAD59,
+    0x5E8451D0, 0x5F8BCCDB, 0x60962665, 0x61A3666D,
+    0x62B39509, 0x63C6BA64, 0x64DCDEC3, 0x65F60A7F,
+    0x6712460B, 0x683199ED, 0x69540EC9, 0x6A79AD56,
+    0x6BA27E65, 0x6CCE8AE1, 0x6DFDDBCC, 0x6F307A41,
+    0x70666F76, 0x719FC4B9, 0x72DC8374, 0x741CB528,
+    0x75606374, 0x76A7980F, 0x77F25CCE, 0x7940BB9E,
+    0x7A92BE8B, 0x7BE86FBA, 0x7D41D96E, 0x7E9F0606,
+    0x80000000,
+};
+
+static const int16_t sine_q15[64] = {
+         0,   3212,   6393,   9512,  12539,  15446,  18204,  20787,
+     23170,  25329,  27245,  28898,  30273,  31356,  32137,  32609,
+     32767,  32609,  32137,  31356,  30273,  28898,  27245,  25329,
+     23170,  20787,  18204,  15446,  12539,   9512,   6393,   3212,
+         0,  -3212,  -6393,  -9512, -12539, -15446, -18204, -20787,
+    -23170, -25329, -27245, -28898, -30273, -31356, -32137, -32609,
+    -32767, -32609, -32137, -31356, -30273, -28898, -27245, -25329,
+    -23170, -20787, -18204, -15446, -12539,  -9512,  -6393,  -3212,
+};
+
+uint32_t pitch_to_inc(int32_t pitch)
+{
+    if (pitch < 0) pitch = 0;
+    if (pitch > PITCH_MAX) pitch = PITCH_MAX;
+
+    uint32_t oct  = (uint32_t)pitch / PITCH_OCTAVE;
+    uint32_t frac = (uint32_t)pitch % PITCH_OCTAVE;
+
+    // Position in the table as Q16: frac * 64 * 65536 / PITCH_OCTAVE == frac * 1024 / 75
+    uint32_t pos = frac * 1024u / 75u;
+    uint32_t i = pos >> 16;
+    uint32_t f = pos & 0xFFFF;
+
+    uint32_t lo = octave_ratio_q30[i];
+    uint32_t ratio = lo + (uint32_t)(((uint64_t)(octave_ratio_q30[i + 1] - lo) * f) >> 16);
+
+    // INC_NOTE0_Q8 * ratio_q30 is Q38; the octave is just a smaller shift.
+    return (uint32_t)(((uint64_t)INC_NOTE0_Q8 * ratio) >> (38 - oct));
+}
+
+int32_t pitch_lfo_sine(uint32_t phase)
+{
+    return sine_q15[phase >> 26];
+}
@@ -0,0 +1,172 @@
+#include "sched.h"
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/timer.h"
+#include "hardware/sync.h"
+
+typedef struct {
+    const char *name;
+    sched_fn_t fn;
+    uint32_t   period_us;
+    uint32_t   next_us;
+    bool       armed;
+    uint32_t   runs;
+    uint32_t   overruns;        // finished past its next deadline
+    uint32_t   late_sum_us;     // start - deadline
+    uint32_t   late_max_us;
+    uint32_t   run_max_us;
+} task_t;
+
+static task_t tasks[SCHED_TASKS];
+static int n_tasks = 0;
+static int wake_alarm = -1;
+static uint32_t wake_at_us;
+static bool wake_armed = false;
+static volatile bool kicked = false;
+static uint32_t idle_us = 0, passes = 0;
+
+static inline bool due(uint32_t deadline, uint32_t now)
+{
+    return (int32_t)(now - deadline) >= 0;
+}
+
+static void wake_alarm_fired(uint alarm)
+{
+    // nothing to do: taking the IRQ ends the WFI
+}
+
+int sched_add(const char *name, sched_fn_t fn, uint32_t period_us)
+{
+    if (n_tasks == SCHED_TASKS) return -1;
+
+    task_t *t = &tasks[n_tasks];
+    t->name = name;
+    t->fn = fn;
+    t->period_us = period_us;
+    t->armed = period_us != SCHED_ONCE;
+    t->next_us = time_us_32() + (period_us == SCHED_ONCE ? 0 : period_us);
+    return n_tasks++;
+}
+
+void sched_at(int id, uint32_t deadline_us)
+{
+    if (id < 0 || id >= n_tasks) return;
+    tasks[id].next_us = deadline_us;
+    tasks[id].armed = true;
+}
+
+void sched_kick(void)
+{
+    kicked = true;
+}
+
+static void run_task(task_t *t, uint32_t now)
+{
+    uint32_t late = now - t->next_us;
+    t->late_sum_us += late;
+    if (late > t->late_max_us) t->late_max_us = late;
+
+    t->fn();
+
+    uint32_t end = time_us_32();
+    uint32_t dt = end - now;
+    if (dt > t->run_max_us) t->run_max_us = dt;
+    t->runs++;
+
+    if (t->period_us == SCHED_ONCE) {
+        t->armed = false;
+        return;
+    }
+    t->next_us += t->period_us;
+    if (due(t->next_us, end)) {
+        // missed a whole period: count it and re-phase rather than burst
+        t->overruns++;
+        t->next_us = end + t->period_us;
+    }
+}
+
+// Earliest armed deadline among the periodic and one-shot tasks.
+static task_t *earliest(void)
+{
+    task_t *best = NULL;
+
+    for (int i = 0; i < n_tasks; i++) {
+        task_t *t = &tasks[i];
+        if (t->period_us == SCHED_POLL || !t->armed) continue;
+        if (!best || (int32_t)(t->next_us - best->next_us) < 0) best = t;
+    }
+    return best;
+}
+
+void sched_run(void)
+{
+    wake_alarm = hardware_alarm_claim_unused(true);
+    hardware_alarm_set_callback((uint)wake_alarm, wake_alarm_fired);
+
+    for (;;) {
+        passes++;
+        for (int i = 0; i < n_tasks; i++) {
+            if (tasks[i].period_us == SCHED_POLL) tasks[i].fn();
+        }
+
+        task_t *t;
+        uint32_t now = time_us_32();
+        while ((t = earliest()) && due(t->next_us, now)) {
+            run_task(t, now);
+            now = time_us_32();
+        }
+
+        // the wake alarm only moves when the earliest deadline does
+        if (t && (!wake_armed || wake_at_us != t->next_us)) {
+            wake_at_us = t->next_us;
+            wake_armed = true;
+            if (hardware_alarm_set_target((uint)wake_alarm, from_us_since_boot(
+                    time_us_64() + (uint32_t)(wake_at_us - now)))) {
+                continue;           // already due
+            }
+        }
+
+        // IRQs off across the check so a kick can't land between it and
+        // the WFI; a pending IRQ still wakes the core, and runs on restore
+        uint32_t irq = save_and_disable_interrupts();
+        if (!kicked) {
+            uint32_t w = time_us_32();
+            __wfi();
+            idle_us += time_us_32() - w;
+        }
+        kicked = false;
+        restore_interrupts(irq);
+
+        if (wake_armed && due(wake_at_us, time_us_32())) wake_armed = false;
+    }
+}
+
+void sched_print(void)
+{
+    static uint32_t last_us, last_idle, last_passes;
+    uint32_t now = time_us_32();
+    uint32_t dt = now - last_us;
+    uint32_t idle = idle_us - last_idle;
+
+    if (!dt) return;
+    printf("[SCHED] %lu passes/s, core 0 in WFI %lu%%\n",
+           (unsigned long)((uint64_t)(passes - last_passes) * 1000000u / dt),
+           (unsigned long)((uint64_t)idle * 100 / dt));
+    for (int i = 0; i < n_tasks; i++) {
+        task_t *t = &tasks[i];
+        if (t->period_us == SCHED_POLL) {
+            printf("  %-10s poll\n", t->name);
+            continue;
+        }
+        printf("  %-10s %6lu us: %lu runs, late avg %lu max %lu us, run max %lu us, %lu overruns\n",
+               t->name, t->period_us == SCHED_ONCE ? 0ul : (unsigned long)t->period_us,
+               (unsigned long)t->runs,
+               (unsigned long)(t->runs ? t->late_sum_us / t->runs : 0),
+               (unsigned long)t->late_max_us, (unsigned long)t->run_max_us,
+               (unsigned long)t->overruns);
+        t->late_max_us = t->run_max_us = 0;
+    }
+    last_us = now;
+    last_idle = idle_us;
+    last_passes = passes;
+}
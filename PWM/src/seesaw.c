@@ -1,67 +1,835 @@
 #include "seesaw.h"
 #include "pico/stdlib.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include <stdio.h>
 #include <string.h>
 
+#define I2C_FIFO_DEPTH  16
 
-void seesaw_bus_init(uint32_t hz) {
-    i2c_init(NEOTRELLIS_I2C, hz);
-    gpio_set_function(NEOTRELLIS_SDA, GPIO_FUNC_I2C);
-    gpio_set_function(NEOTRELLIS_SCL, GPIO_FUNC_I2C);
-    gpio_pull_up(NEOTRELLIS_SDA);
-    gpio_pull_up(NEOTRELLIS_SCL);
-    
+// === Transaction engine ===
+//
+// Writes: the header, the optional prefix and the payload are fed into the
+// TX FIFO straight from the caller's buffers by the TX_EMPTY interrupt; the
+// controller wants 16-bit command words, so DMA would need a widened copy.
+// Reads: select the register, wait delay_us on a hardware alarm, then DMA
+// pushes the read commands and DMA pulls the bytes into the caller's buffer.
+// STOP_DET ends each phase; TX_ABRT fails the transaction. A transaction
+// to a chip still settling from the last write waits on an alarm first.
+//
+// There is one engine per I2C controller, each with its own queues, DMA
+// channels and interrupt, so transactions on different buses overlap.
+
+typedef enum { PH_IDLE, PH_HOLD, PH_WRITE, PH_DELAY, PH_READ } phase_t;
+
+// One FIFO per class; the next transaction is picked at every boundary in
+// this order, so a keypad read waits for at most the transaction in flight.
+static const uint8_t pick_order[SEESAW_PRIO_COUNT] = {
+    SEESAW_PRIO_KEYPAD, SEESAW_PRIO_NORMAL, SEESAW_PRIO_LED
+};
+static const char *const prio_names[SEESAW_PRIO_COUNT] = { "normal", "keypad", "led" };
+
+struct seesaw_bus {
+    i2c_inst_t *i2c;
+    i2c_hw_t *hw;
+    uint8_t  num;
+    bool     open;
+    uint     sda, scl;
+    uint32_t hz;
+    int      cmd_dma, rx_dma;
+    uint16_t read_cmds[SEESAW_MAX_READ];
+    uint16_t read_last;
+
+    seesaw_xfer_t *q_head[SEESAW_PRIO_COUNT], *q_tail[SEESAW_PRIO_COUNT];
+    uint32_t q_depth[SEESAW_PRIO_COUNT];
+    seesaw_xfer_t *cur;
+    const seesaw_timing_t *cur_timing;
+    volatile phase_t phase;
+    uint32_t phase_us;          // phase start, for the watchdog
+    uint32_t phase_max_us;      // longest the phase may take
+    bool     cur_failed;
+    bool     cur_nack;
+    bool     need_recover;
+    bool     finishing;
+    bool     kicking;           // the budget alarm can fire from inside pick
+    uint32_t depth, depth_max;
+
+    // Token bucket per class, in bus bytes per SEESAW_QOS_WINDOW_US, from
+    // the class's share of the bus at hz; 0 = unlimited. May run into debt
+    // by one transaction.
+    uint8_t  share[SEESAW_PRIO_COUNT];
+    uint32_t budget[SEESAW_PRIO_COUNT];
+    int32_t  tokens[SEESAW_PRIO_COUNT];
+    uint32_t refill_us;
+    bool     budget_alarm_armed;
+
+    seesaw_qos_stats_t qos[SEESAW_PRIO_COUNT];
+
+    // gather list for the write phase
+    uint8_t  hdr[2];
+    const uint8_t *seg[3];
+    uint16_t seg_len[3];
+    int      seg_i;
+    uint16_t seg_pos;
+    uint32_t remaining;
+
+    // One per transaction descriptor run; a read counts once for its
+    // register select and read phases together.
+    uint32_t transactions;
+    uint32_t done_count, fail_count;
+    uint32_t lat_sum_us, lat_max_us;
+    uint32_t bytes, busy_us;
+
+    // the last write's settle time
+    uint8_t  hold_addr;
+    uint32_t hold_until_us;
+    uint32_t holds, hold_us;
+
+    // self-healing
+    uint32_t retries, timeouts, arb_lost, stuck_sda;
+    uint32_t timer_misses;      // HOLD / DELAY alarms not armed or not fired
+    uint32_t recoveries, recover_sum_us, recover_max_us;
+    uint32_t heal_max_us;       // first failure -> eventual success
+};
+
+static seesaw_bus_t buses[SEESAW_BUSES];
+
+// Which bus each 7-bit address lives on; everything starts on bus 0.
+static uint8_t route[128];
+
+static seesaw_op_stats_t ops[SEESAW_OP_SLOTS];
+static int op_count = 0;
+
+static seesaw_op_stats_t *op_stats(uint8_t module, uint8_t reg) {
+    for (int i = 0; i < op_count; i++)
+        if (ops[i].module == module && ops[i].reg == reg) return &ops[i];
+    if (op_count == SEESAW_OP_SLOTS - 1) {
+        ops[op_count].module = ops[op_count].reg = 0xFF;    // everything else
+        return &ops[op_count];
+    }
+    ops[op_count].module = module;
+    ops[op_count].reg = reg;
+    return &ops[op_count++];
 }
 
+static repeating_timer_t watchdog_timer;
+static bool watchdog_armed = false;
+static bool in_watchdog = false;
 
+static seesaw_timing_t timing[SEESAW_TIMING_SLOTS];
+static int timing_count = 0;
 
-bool seesaw_write(uint8_t addr, uint8_t module, uint8_t reg,
-                  const uint8_t *data, uint16_t len) {
-    uint8_t buf[2 + len];
-    buf[0] = module;
-    buf[1] = reg;
-    for (uint16_t i = 0; i < len; i++) buf[2 + i] = data[i];
+const seesaw_timing_t *seesaw_timing(uint8_t module, uint8_t reg) {
+    for (int i = 0; i < timing_count; i++)
+        if (timing[i].module == module && timing[i].reg == reg) return &timing[i];
+    return NULL;
+}
+
+bool seesaw_set_timing(uint8_t module, uint8_t reg, uint16_t read_us, uint16_t settle_us) {
+    seesaw_timing_t *t = (seesaw_timing_t *)seesaw_timing(module, reg);
+
+    if (!t) {
+        if (timing_count == SEESAW_TIMING_SLOTS) return false;
+        t = &timing[timing_count];
+        t->module = module;
+        t->reg = reg;
+    }
+    // entries are only read from the engine at transaction start
+    uint32_t irq = save_and_disable_interrupts();
+    t->read_us = read_us;
+    t->settle_us = settle_us;
+    if (t == &timing[timing_count]) timing_count++;
+    restore_interrupts(irq);
+    return true;
+}
+
+static void engine_start(seesaw_bus_t *b, seesaw_xfer_t *x);
+static void engine_kick(seesaw_bus_t *b);
 
-    int written = i2c_write_blocking(NEOTRELLIS_I2C, addr, buf, 2 + len, false);
-    return written == (int)(2 + len);
+uint32_t seesaw_transactions(void) {
+    uint32_t n = 0;
+    for (int i = 0; i < SEESAW_BUSES; i++) n += buses[i].transactions;
+    return n;
 }
 
+uint32_t seesaw_xfer_cost(const seesaw_xfer_t *x) {
+    uint32_t n = 1 + 2 + (x->pre ? x->pre_len : 0);
+    return x->read ? n + 1 + x->len : n + x->len;
+}
 
+static void budget_refill(seesaw_bus_t *b) {
+    uint32_t now = time_us_32();
+    uint32_t dt = now - b->refill_us;
+    b->refill_us = now;
 
-bool seesaw_write_buf(uint8_t addr, uint8_t module, uint8_t reg,
-                  const uint8_t *data, size_t len)
-{
-    
-    size_t total = 2 + len;
-    uint8_t frame[2 + 30];            
-    frame[0] = module;
-    frame[1] = reg;
-    if (len) memcpy(&frame[2], data, len);
+    for (int p = 0; p < SEESAW_PRIO_COUNT; p++) {
+        if (!b->budget[p]) continue;
+        int64_t t = b->tokens[p] + (int64_t)dt * b->budget[p] / SEESAW_QOS_WINDOW_US;
+        b->tokens[p] = (int32_t)(t > (int64_t)b->budget[p] ? b->budget[p] : t);
+    }
+}
+
+// Recomputes the budgets from the shares at the bus's current rate; the
+// buckets keep their level, capped at the new size.
+static void budget_update(seesaw_bus_t *b) {
+    for (int p = 0; p < SEESAW_PRIO_COUNT; p++) {
+        uint64_t window = (uint64_t)b->hz / 9 * SEESAW_QOS_WINDOW_US / 1000000u;
+        uint32_t bytes = (uint32_t)(window * b->share[p] / 100u);
+        b->budget[p] = b->share[p] ? (bytes ? bytes : 1) : 0;
+        if (b->tokens[p] > (int32_t)b->budget[p]) b->tokens[p] = (int32_t)b->budget[p];
+    }
+}
+
+static int64_t budget_alarm(alarm_id_t id, void *user) {
+    seesaw_bus_t *b = user;
+    b->budget_alarm_armed = false;
+    engine_kick(b);
+    return 0;
+}
+
+// Highest class with work and budget. A class out of budget is skipped and
+// a wake-up is armed for when it is back in credit.
+static seesaw_xfer_t *engine_pick(seesaw_bus_t *b) {
+    budget_refill(b);
+
+    for (int i = 0; i < SEESAW_PRIO_COUNT; i++) {
+        int p = pick_order[i];
+        seesaw_xfer_t *x = b->q_head[p];
+        if (!x) continue;
+
+        if (b->budget[p] && b->tokens[p] <= 0) {
+            b->qos[p].budget_stalls++;
+            if (!b->budget_alarm_armed) {
+                uint32_t wait = (uint32_t)((int64_t)(1 - b->tokens[p]) * SEESAW_QOS_WINDOW_US / b->budget[p]);
+                b->budget_alarm_armed = add_alarm_in_us(wait < 100 ? 100 : wait, budget_alarm, b, true) > 0;
+            }
+            continue;
+        }
+
+        b->q_head[p] = x->next;
+        if (!b->q_head[p]) b->q_tail[p] = NULL;
+        b->q_depth[p]--;
+        b->depth--;
+
+        // everything still queued in a lower class was passed over
+        for (int j = i + 1; j < SEESAW_PRIO_COUNT; j++)
+            if (b->q_head[pick_order[j]]) b->qos[pick_order[j]].passed_over++;
+
+        if (b->budget[p]) b->tokens[p] -= (int32_t)seesaw_xfer_cost(x);
+        return x;
+    }
+    return NULL;
+}
+
+static void engine_kick(seesaw_bus_t *b) {
+    if (b->cur || b->finishing || b->kicking) return;
+    b->kicking = true;
+    seesaw_xfer_t *x = engine_pick(b);
+    b->kicking = false;
+    if (x) engine_start(b, x);
+}
+
+// Open-drain by hand: drive low, or let the pull-up take it high.
+static void line_set(uint pin, bool high) {
+    gpio_set_dir(pin, high ? GPIO_IN : GPIO_OUT);
+    busy_wait_us_32(5);         // 100 kHz
+}
+
+static void engine_recover(seesaw_bus_t *b) {
+    uint32_t t0 = time_us_32();
+
+    b->hw->intr_mask = 0;
+    b->hw->dma_cr = 0;
+    dma_channel_abort(b->cmd_dma);
+    dma_channel_abort(b->rx_dma);
+
+    gpio_put(b->sda, 0);
+    gpio_put(b->scl, 0);
+    gpio_set_dir(b->sda, GPIO_IN);
+    gpio_set_dir(b->scl, GPIO_IN);
+    gpio_set_function(b->sda, GPIO_FUNC_SIO);
+    gpio_set_function(b->scl, GPIO_FUNC_SIO);
+    busy_wait_us_32(5);
+
+    // a slave mid-byte lets go of SDA within nine clocks
+    for (int i = 0; i < 9 && !gpio_get(b->sda); i++) {
+        line_set(b->scl, false);
+        line_set(b->scl, true);
+    }
+    // STOP: SDA rises while SCL is high
+    line_set(b->scl, false);
+    line_set(b->sda, false);
+    line_set(b->scl, true);
+    line_set(b->sda, true);
+
+    gpio_set_function(b->sda, GPIO_FUNC_I2C);
+    gpio_set_function(b->scl, GPIO_FUNC_I2C);
+    i2c_init(b->i2c, b->hz);
+    b->hw->intr_mask = 0;
+    b->hw->dma_cr = 0;
+    b->need_recover = false;
+
+    uint32_t dt = time_us_32() - t0;
+    b->recoveries++;
+    b->recover_sum_us += dt;
+    if (dt > b->recover_max_us) b->recover_max_us = dt;
+}
+
+void seesaw_bus_recover(seesaw_bus_t *b) {
+    uint32_t irq = save_and_disable_interrupts();
+    if (b->phase == PH_IDLE) engine_recover(b);
+    else b->need_recover = true;        // after the transaction in flight
+    restore_interrupts(irq);
+}
+
+// A failed attempt goes back to the head of its class after a short
+// backoff, while it has attempts and time left.
+static bool engine_retry(seesaw_bus_t *b, seesaw_xfer_t *x, uint32_t now) {
+    if (x->no_retry || x->attempts > SEESAW_RETRIES ||
+        now - x->first_us >= SEESAW_RETRY_BUDGET_US) return false;
+
+    uint8_t p = x->prio;
+    x->next = b->q_head[p];
+    b->q_head[p] = x;
+    if (!b->q_tail[p]) b->q_tail[p] = x;
+    b->q_depth[p]++;
+    b->depth++;
+
+    b->hold_addr = x->addr;
+    b->hold_until_us = now + SEESAW_RETRY_BACKOFF_US;
+    b->retries++;
+    return true;
+}
+
+static void watchdog_disarm_if_idle(void);
+
+static void engine_finish(seesaw_bus_t *b) {
+    seesaw_xfer_t *x = b->cur;
+    uint32_t now = time_us_32();
+    seesaw_op_stats_t *op = op_stats(x->module, x->reg);
+
+    b->hw->intr_mask = 0;
+    b->hw->dma_cr = 0;
+    b->phase = PH_IDLE;
+    b->cur = NULL;
+    b->bytes += seesaw_xfer_cost(x);
+    b->busy_us += now - x->start_us;
+
+    if (b->need_recover) engine_recover(b);
+    if (b->cur_failed) {
+        if (b->cur_nack) op->nacks++;
+        else op->bus_errors++;
+        if (engine_retry(b, x, now)) {
+            op->retries++;
+            engine_kick(b);
+            return;
+        }
+    }
 
-    size_t used = total;     
-    size_t cap  = 2 + 30;        
-    if (used < cap) {
-        memset(&frame[used], 0, cap - used);
+    x->ok = !b->cur_failed;
+    x->latency_us = now - x->submit_us;
+    b->lat_sum_us += x->latency_us;
+    if (x->latency_us > b->lat_max_us) b->lat_max_us = x->latency_us;
+    if (x->ok) b->done_count++;
+    else b->fail_count++;
+    op->count++;
+    if (!x->ok) op->failed++;
+    if (x->ok && x->attempts > 1 && now - x->first_us > b->heal_max_us) b->heal_max_us = now - x->first_us;
+    if (x->ok && !x->read && b->cur_timing && b->cur_timing->settle_us) {
+        b->hold_addr = x->addr;
+        b->hold_until_us = now + b->cur_timing->settle_us;
     }
 
+    seesaw_qos_stats_t *q = &b->qos[x->prio];
+    q->done++;
+    q->bytes += seesaw_xfer_cost(x);
+    if (x->latency_us > q->latency_max_us) q->latency_max_us = x->latency_us;
 
+    // anything submitted from the callback queues behind what is waiting
+    b->finishing = true;
+    x->busy = false;
+    if (x->done) x->done(x);
+    b->finishing = false;
 
-    int wrote = i2c_write_blocking(NEOTRELLIS_I2C, addr, frame, total, false);
+    engine_kick(b);
+    watchdog_disarm_if_idle();
+}
+
+// Keeps the TX FIFO topped up from the gather list; STOP on the last byte.
+static void engine_fill(seesaw_bus_t *b) {
+    i2c_hw_t *hw = b->hw;
+
+    while (b->remaining && hw->txflr < I2C_FIFO_DEPTH) {
+        while (b->seg_pos >= b->seg_len[b->seg_i]) {
+            b->seg_i++;
+            b->seg_pos = 0;
+        }
+        uint32_t cmd = b->seg[b->seg_i][b->seg_pos++];
+        if (--b->remaining == 0) cmd |= I2C_IC_DATA_CMD_STOP_BITS;
+        hw->data_cmd = cmd;
+    }
+    if (!b->remaining) hw->intr_mask &= ~I2C_IC_INTR_MASK_M_TX_EMPTY_BITS;
+}
+
+static void engine_start_read(seesaw_bus_t *b) {
+    uint16_t n = b->cur->len;
+
+    b->read_cmds[b->read_last] = I2C_IC_DATA_CMD_CMD_BITS;
+    b->read_cmds[n - 1] = I2C_IC_DATA_CMD_CMD_BITS | I2C_IC_DATA_CMD_STOP_BITS;
+    b->read_last = (uint16_t)(n - 1);
+
+    b->phase = PH_READ;
+    b->phase_us = time_us_32();
+    b->phase_max_us = SEESAW_XFER_TIMEOUT_US + 100u * seesaw_xfer_cost(b->cur);
+    b->hw->intr_mask = I2C_IC_INTR_MASK_M_STOP_DET_BITS | I2C_IC_INTR_MASK_M_TX_ABRT_BITS;
+    b->hw->dma_cr = I2C_IC_DMA_CR_RDMAE_BITS | I2C_IC_DMA_CR_TDMAE_BITS;
+    dma_channel_transfer_to_buffer_now(b->rx_dma, b->cur->in, n);
+    dma_channel_transfer_from_buffer_now(b->cmd_dma, b->read_cmds, n);
+}
+
+static int64_t engine_delay_done(alarm_id_t id, void *user) {
+    seesaw_bus_t *b = user;
+    if (b->phase == PH_DELAY) engine_start_read(b);
+    return 0;
+}
 
+static void engine_go(seesaw_bus_t *b);
 
-    
-    return wrote == (int)total;
+static int64_t engine_hold_done(alarm_id_t id, void *user) {
+    seesaw_bus_t *b = user;
+    if (b->phase == PH_HOLD) engine_go(b);
+    return 0;
 }
 
+static void watchdog_arm(void);
 
+static void engine_start(seesaw_bus_t *b, seesaw_xfer_t *x) {
+    watchdog_arm();
+    b->cur = x;
+    b->cur_failed = false;
+    b->cur_nack = false;
+    b->cur_timing = seesaw_timing(x->module, x->reg);
 
+    uint32_t now = time_us_32();
+    uint32_t wait = now - x->submit_us;
+    if (wait > b->qos[x->prio].wait_max_us) b->qos[x->prio].wait_max_us = wait;
 
+    int32_t hold = (int32_t)(b->hold_until_us - now);
+    if (x->addr == b->hold_addr && hold > 0) {
+        b->holds++;
+        b->hold_us += (uint32_t)hold;
+        b->phase = PH_HOLD;
+        b->phase_us = now;
+        b->phase_max_us = (uint32_t)hold + SEESAW_XFER_TIMEOUT_US;
+        if (add_alarm_in_us((uint64_t)hold, engine_hold_done, b, true) >= 0) return;
+        // no alarm slot: go now and let a NACK's retry cover the settle time
+        b->timer_misses++;
+    }
+    engine_go(b);
+}
+
+static void engine_go(seesaw_bus_t *b) {
+    i2c_hw_t *hw = b->hw;
+    seesaw_xfer_t *x = b->cur;
+
+    // SDA held low with nothing in flight: a slave is stuck mid-byte
+    if (!gpio_get(b->sda) && !(hw->status & I2C_IC_STATUS_ACTIVITY_BITS)) {
+        b->stuck_sda++;
+        engine_recover(b);
+    }
+
+    x->start_us = time_us_32();
+    if (!x->attempts++) x->first_us = x->start_us;
+    hw->enable = 0;
+    hw->tar = x->addr;
+    hw->enable = 1;
+
+    b->hdr[0] = x->module;
+    b->hdr[1] = x->reg;
+    b->seg[0] = b->hdr;  b->seg_len[0] = 2;
+    b->seg[1] = x->pre;  b->seg_len[1] = x->pre ? x->pre_len : 0;
+    b->seg[2] = x->out;  b->seg_len[2] = (!x->read && x->out) ? x->len : 0;
+    b->seg_i = 0;
+    b->seg_pos = 0;
+    b->remaining = (uint32_t)b->seg_len[0] + b->seg_len[1] + b->seg_len[2];
+
+    b->transactions++;
+    b->phase = PH_WRITE;
+    b->phase_us = x->start_us;
+    b->phase_max_us = SEESAW_XFER_TIMEOUT_US + 100u * seesaw_xfer_cost(x);
+    hw->intr_mask = I2C_IC_INTR_MASK_M_TX_EMPTY_BITS |
+                    I2C_IC_INTR_MASK_M_STOP_DET_BITS |
+                    I2C_IC_INTR_MASK_M_TX_ABRT_BITS;
+}
+
+static void engine_phase_done(seesaw_bus_t *b) {
+    if (b->cur_failed) {
+        engine_finish(b);
+    } else if (b->phase == PH_WRITE && b->cur->read) {
+        uint32_t delay = b->cur->delay_us ? b->cur->delay_us :
+                         b->cur_timing ? b->cur_timing->read_us : SEESAW_READ_DELAY_US;
+        b->hw->intr_mask = 0;
+        if (delay) {
+            b->phase = PH_DELAY;
+            b->phase_us = time_us_32();
+            b->phase_max_us = delay + SEESAW_XFER_TIMEOUT_US;
+            if (add_alarm_in_us(delay, engine_delay_done, b, true) >= 0) return;
+            b->timer_misses++;      // no alarm slot: read now rather than never
+        }
+        engine_start_read(b);
+    } else {
+        // the last byte may still be on its way out of the RX FIFO
+        if (b->phase == PH_READ) while (dma_channel_is_busy(b->rx_dma)) tight_loop_contents();
+        engine_finish(b);
+    }
+}
+
+static void engine_irq(seesaw_bus_t *b) {
+    i2c_hw_t *hw = b->hw;
+    uint32_t stat = hw->intr_stat;
+
+    if (stat & I2C_IC_INTR_STAT_R_TX_ABRT_BITS) {
+        uint32_t src = hw->tx_abrt_source;
+        (void)hw->clr_tx_abrt;
+        b->cur_failed = true;
+        b->cur_nack = src & (I2C_IC_TX_ABRT_SOURCE_ABRT_7B_ADDR_NOACK_BITS |
+                             I2C_IC_TX_ABRT_SOURCE_ABRT_TXDATA_NOACK_BITS);
+        if (src & I2C_IC_TX_ABRT_SOURCE_ARB_LOST_BITS) {
+            b->arb_lost++;
+            b->need_recover = true;
+        }
+        b->remaining = 0;
+        hw->intr_mask &= ~I2C_IC_INTR_MASK_M_TX_EMPTY_BITS;
+        if (b->phase == PH_READ) {
+            dma_channel_abort(b->cmd_dma);
+            dma_channel_abort(b->rx_dma);
+        }
+    }
+    if (stat & I2C_IC_INTR_STAT_R_TX_EMPTY_BITS) engine_fill(b);
+    if (stat & I2C_IC_INTR_STAT_R_STOP_DET_BITS) {
+        (void)hw->clr_stop_det;
+        if (b->cur) engine_phase_done(b);
+    }
+}
+
+static void seesaw_i2c0_irq(void) { engine_irq(&buses[0]); }
+static void seesaw_i2c1_irq(void) { engine_irq(&buses[1]); }
+
+// A byte phase that stops making progress, e.g. a slave stretching SCL
+// forever, fails the attempt and recovers the bus. A HOLD or DELAY whose
+// alarm never came has waited long enough, so it moves straight on.
+static bool engine_watchdog(repeating_timer_t *rt) {
+    uint32_t now = time_us_32();
+    bool busy = false;
+
+    in_watchdog = true;
+    for (int i = 0; i < SEESAW_BUSES; i++) {
+        seesaw_bus_t *b = &buses[i];
+        uint32_t irq = save_and_disable_interrupts();
+        if (b->cur && b->phase != PH_IDLE && now - b->phase_us > b->phase_max_us) {
+            if (b->phase == PH_HOLD) {
+                b->timer_misses++;
+                engine_go(b);
+            } else if (b->phase == PH_DELAY) {
+                b->timer_misses++;
+                engine_start_read(b);
+            } else {
+                b->timeouts++;
+                b->cur_failed = true;
+                b->need_recover = true;
+                engine_finish(b);
+            }
+        }
+        busy |= b->cur != NULL;
+        restore_interrupts(irq);
+    }
+    in_watchdog = false;
+
+    // the engine only runs on core 0 and its IRQs don't preempt this one
+    if (!busy) watchdog_armed = false;
+    return busy;
+}
+
+static bool engine_idle(void) {
+    for (int i = 0; i < SEESAW_BUSES; i++)
+        if (buses[i].cur) return false;
+    return true;
+}
+
+// The watchdog runs only while a transaction is in flight, so an idle
+// engine never wakes core 0. A failed arm is retried at the next start.
+static void watchdog_arm(void) {
+    if (watchdog_armed) return;
+    watchdog_armed = add_repeating_timer_ms(SEESAW_WATCHDOG_MS, engine_watchdog, NULL, &watchdog_timer);
+}
+
+// A finish inside the watchdog leaves the disarm to its return value.
+static void watchdog_disarm_if_idle(void) {
+    if (!watchdog_armed || in_watchdog || !engine_idle()) return;
+    cancel_repeating_timer(&watchdog_timer);
+    watchdog_armed = false;
+}
+
+static void engine_init(seesaw_bus_t *b, i2c_inst_t *i2c, uint32_t hz) {
+    b->i2c = i2c;
+    b->hz = hz;
+    b->hw = i2c_get_hw(i2c);
+    b->hw->intr_mask = 0;
+
+    for (int i = 0; i < SEESAW_MAX_READ; i++) b->read_cmds[i] = I2C_IC_DATA_CMD_CMD_BITS;
+
+    b->cmd_dma = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(b->cmd_dma);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, i2c_get_dreq(i2c, true));
+    dma_channel_configure(b->cmd_dma, &c, &b->hw->data_cmd, b->read_cmds, 0, false);
+
+    b->rx_dma = dma_claim_unused_channel(true);
+    c = dma_channel_get_default_config(b->rx_dma);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_dreq(&c, i2c_get_dreq(i2c, false));
+    dma_channel_configure(b->rx_dma, &c, NULL, &b->hw->data_cmd, 0, false);
+
+    b->share[SEESAW_PRIO_LED] = SEESAW_LED_SHARE;
+    budget_update(b);
+    b->refill_us = time_us_32();
+    for (int p = 0; p < SEESAW_PRIO_COUNT; p++) b->tokens[p] = (int32_t)b->budget[p];
+
+    uint irq = I2C0_IRQ + i2c_hw_index(i2c);
+    irq_set_exclusive_handler(irq, i2c_hw_index(i2c) ? seesaw_i2c1_irq : seesaw_i2c0_irq);
+    irq_set_enabled(irq, true);
+    b->open = true;
+}
+
+seesaw_bus_t *seesaw_bus(uint8_t num) {
+    return num < SEESAW_BUSES && buses[num].open ? &buses[num] : NULL;
+}
+
+uint8_t seesaw_bus_num(const seesaw_bus_t *bus) {
+    return bus->num;
+}
+
+i2c_inst_t *seesaw_bus_i2c(const seesaw_bus_t *bus) {
+    return bus->i2c;
+}
+
+uint32_t seesaw_bus_speed(const seesaw_bus_t *bus) {
+    return bus->hz;
+}
+
+// Retunes between transactions; anything queued runs at the new rate.
+uint32_t seesaw_bus_set_speed(seesaw_bus_t *b, uint32_t hz) {
+    for (;;) {
+        uint32_t irq = save_and_disable_interrupts();
+        if (b->phase == PH_IDLE) {
+            uint32_t got = i2c_set_baudrate(b->i2c, hz);
+            b->hz = hz;
+            budget_update(b);
+            restore_interrupts(irq);
+            return got;
+        }
+        restore_interrupts(irq);
+        tight_loop_contents();
+    }
+}
+
+uint32_t seesaw_bus_faults(const seesaw_bus_t *b) {
+    return b->retries + b->fail_count + b->timeouts + b->recoveries;
+}
+
+void seesaw_bus_assign(uint8_t addr, seesaw_bus_t *bus) {
+    if (addr < count_of(route) && bus) route[addr] = bus->num;
+}
+
+seesaw_bus_t *seesaw_bus_for(uint8_t addr) {
+    return &buses[addr < count_of(route) ? route[addr] : 0];
+}
+
+bool seesaw_submit(seesaw_xfer_t *x) {
+    if (x->busy) return false;
+    if (x->read && (x->len == 0 || x->len > SEESAW_MAX_READ)) return false;
+    if (x->prio >= SEESAW_PRIO_COUNT) return false;
+
+    seesaw_bus_t *b = x->bus ? x->bus : seesaw_bus_for(x->addr);
+    if (!b->open) return false;
+
+    x->busy = true;
+    x->ok = false;
+    x->next = NULL;
+    x->on = b;
+    x->attempts = 0;
+    x->submit_us = time_us_32();
+
+    uint32_t irq = save_and_disable_interrupts();
+    uint8_t p = x->prio;
+    if (b->q_tail[p]) b->q_tail[p]->next = x;
+    else b->q_head[p] = x;
+    b->q_tail[p] = x;
+    b->q_depth[p]++;
+    if (++b->depth > b->depth_max) b->depth_max = b->depth;
+    engine_kick(b);
+    restore_interrupts(irq);
+    return true;
+}
+
+uint32_t seesaw_queue_depth(void) {
+    uint32_t n = 0;
+    for (int i = 0; i < SEESAW_BUSES; i++) n += buses[i].depth + (buses[i].cur ? 1 : 0);
+    return n;
+}
+
+uint32_t seesaw_queue_depth_prio(uint8_t prio) {
+    uint32_t n = 0;
+    if (prio >= SEESAW_PRIO_COUNT) return 0;
+    for (int i = 0; i < SEESAW_BUSES; i++) n += buses[i].q_depth[prio];
+    return n;
+}
+
+// Budgets are per bus: each controller has its own bandwidth.
+void seesaw_set_budget(uint8_t prio, uint8_t share_pct) {
+    if (prio >= SEESAW_PRIO_COUNT) return;
+    for (int i = 0; i < SEESAW_BUSES; i++) {
+        seesaw_bus_t *b = &buses[i];
+        uint32_t irq = save_and_disable_interrupts();
+        b->share[prio] = share_pct > 100 ? 100 : share_pct;
+        budget_update(b);
+        b->tokens[prio] = (int32_t)b->budget[prio];
+        if (b->open) engine_kick(b);
+        restore_interrupts(irq);
+    }
+}
+
+const seesaw_qos_stats_t *seesaw_qos_stats(const seesaw_bus_t *bus, uint8_t prio) {
+    return bus && prio < SEESAW_PRIO_COUNT ? &bus->qos[prio] : NULL;
+}
+
+void seesaw_engine_print(void) {
+    static uint32_t last_bytes[SEESAW_BUSES], last_busy[SEESAW_BUSES], last_us;
+    uint32_t now = time_us_32();
+    uint32_t dt = now - last_us;
+
+    for (int i = 0; i < SEESAW_BUSES; i++) {
+        seesaw_bus_t *b = &buses[i];
+        if (!b->open) continue;
+
+        uint32_t n = b->done_count + b->fail_count;
+        uint32_t bytes = b->bytes - last_bytes[i];
+        uint32_t busy = b->busy_us - last_busy[i];
+        printf("[SEESAW] bus %d (i2c%u): queue %lu (max %lu), %lu done, %lu failed, "
+               "latency avg %lu us, max %lu us, %lu B/s, %lu%% busy, %lu settle holds (%lu us)\n",
+               i, i2c_hw_index(b->i2c),
+               (unsigned long)(b->depth + (b->cur ? 1 : 0)), (unsigned long)b->depth_max,
+               (unsigned long)b->done_count, (unsigned long)b->fail_count,
+               (unsigned long)(n ? b->lat_sum_us / n : 0), (unsigned long)b->lat_max_us,
+               (unsigned long)(dt ? (uint64_t)bytes * 1000000u / dt : 0),
+               (unsigned long)(dt ? (uint64_t)busy * 100u / dt : 0),
+               (unsigned long)b->holds, (unsigned long)b->hold_us);
+        for (int p = 0; p < SEESAW_PRIO_COUNT; p++) {
+            const seesaw_qos_stats_t *q = &b->qos[p];
+            printf("  %-6s %6lu done %7lu B, wait max %5lu us, latency max %5lu us, passed over %lu, "
+                   "budget %u%% (%lu B/window) stalls %lu\n",
+                   prio_names[p], (unsigned long)q->done, (unsigned long)q->bytes,
+                   (unsigned long)q->wait_max_us, (unsigned long)q->latency_max_us,
+                   (unsigned long)q->passed_over, b->share[p], (unsigned long)b->budget[p],
+                   (unsigned long)q->budget_stalls);
+        }
+        printf("  health: %lu retries, %lu timeouts, %lu arbitration lost, %lu stuck SDA, "
+               "%lu timer misses; "
+               "%lu recoveries avg %lu us, max %lu us; worst healed transaction %lu us\n",
+               (unsigned long)b->retries, (unsigned long)b->timeouts,
+               (unsigned long)b->arb_lost, (unsigned long)b->stuck_sda,
+               (unsigned long)b->timer_misses,
+               (unsigned long)b->recoveries,
+               (unsigned long)(b->recoveries ? b->recover_sum_us / b->recoveries : 0),
+               (unsigned long)b->recover_max_us, (unsigned long)b->heal_max_us);
+        last_bytes[i] = b->bytes;
+        last_busy[i] = b->busy_us;
+    }
+    last_us = now;
+
+    printf("  %-5s %8s %6s %6s %6s %6s\n", "op", "done", "nack", "buserr", "retry", "failed");
+    for (int i = 0; i < op_count + (op_count == SEESAW_OP_SLOTS - 1 ? 1 : 0); i++) {
+        const seesaw_op_stats_t *o = &ops[i];
+        printf("  %02X:%02X %8lu %6lu %6lu %6lu %6lu\n", o->module, o->reg,
+               (unsigned long)o->count, (unsigned long)o->nacks, (unsigned long)o->bus_errors,
+               (unsigned long)o->retries, (unsigned long)o->failed);
+    }
+}
+
+// === Blocking wrappers ===
+// For boot code and anything that needs the answer right away. Must not be
+// called from an interrupt: the engine completes in interrupts.
+
+bool seesaw_transfer(seesaw_xfer_t *x) {
+    if (!seesaw_submit(x)) return false;
+    while (x->busy) tight_loop_contents();
+    return x->ok;
+}
+
+static void bus_open(uint8_t num, i2c_inst_t *i2c, uint sda, uint scl, uint32_t hz) {
+    i2c_init(i2c, hz);
+    gpio_set_function(sda, GPIO_FUNC_I2C);
+    gpio_set_function(scl, GPIO_FUNC_I2C);
+    gpio_pull_up(sda);
+    gpio_pull_up(scl);
+    buses[num].num = num;
+    buses[num].sda = sda;
+    buses[num].scl = scl;
+    engine_init(&buses[num], i2c, hz);
+}
+
+void seesaw_bus_init(uint32_t hz) {
+    bus_open(0, NEOTRELLIS_I2C, NEOTRELLIS_SDA, NEOTRELLIS_SCL, hz);
+    bus_open(1, NEOTRELLIS_I2C_B, NEOTRELLIS_SDA_B, NEOTRELLIS_SCL_B, hz);
+}
+
+// Selects the status module's HW_ID register, which has no side effects,
+// explicitly on bus; ACK means a seesaw answers there.
+bool seesaw_probe(seesaw_bus_t *bus, uint8_t addr) {
+    seesaw_xfer_t x = {
+        .bus = bus, .addr = addr, .module = 0x00, .reg = 0x01, .no_retry = true,
+    };
+    return seesaw_transfer(&x);
+}
+
+bool seesaw_write(uint8_t addr, uint8_t module, uint8_t reg,
+                  const uint8_t *data, uint16_t len) {
+    return seesaw_write_sg(addr, module, reg, NULL, 0, data, len);
+}
+
+bool seesaw_write_sg(uint8_t addr, uint8_t module, uint8_t reg,
+                     const uint8_t *pre, uint8_t pre_len,
+                     const uint8_t *data, uint16_t len) {
+    seesaw_xfer_t x = {
+        .addr = addr, .module = module, .reg = reg,
+        .pre = pre, .pre_len = pre_len,
+        .out = data, .len = len,
+    };
+    return seesaw_transfer(&x);
+}
+
+bool seesaw_write_buf(uint8_t addr, uint8_t module, uint8_t reg,
+                  const uint8_t *data, size_t len)
+{
+    return seesaw_write(addr, module, reg, data, (uint16_t)len);
+}
 
 bool seesaw_read(uint8_t addr, uint8_t module, uint8_t reg,
                  uint8_t *data, uint16_t len) {
-    uint8_t hdr[2] = { module, reg };
-
-    if (i2c_write_blocking(NEOTRELLIS_I2C, addr, hdr, 2, true) < 0) return false;
+    return seesaw_read_delay(addr, module, reg, data, len, 0);
+}
 
-    sleep_us(300);
-    return i2c_read_blocking(NEOTRELLIS_I2C, addr, data, len, false) >= 0;
-}
\ No newline at end of file
+bool seesaw_read_delay(uint8_t addr, uint8_t module, uint8_t reg,
+                       uint8_t *data, uint16_t len, uint16_t delay_us) {
+    seesaw_xfer_t x = {
+        .addr = addr, .module = module, .reg = reg,
+        .read = true, .in = data, .len = len, .delay_us = delay_us,
+        .no_retry = delay_us != 0,
+    };
+    return seesaw_transfer(&x);
+}
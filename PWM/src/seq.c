@@ -0,0 +1,199 @@
+#include "seq.h"
+#include "audio.h"
+#include "tuning.h"
+#include "neotrellis.h"
+#include "pico/stdlib.h"
+#include <stdio.h>
+
+static seq_pattern_t patterns[SEQ_PATTERNS] = {
+    [0] = { { 0x1111, 0x0000, 0x0000, 0x0000 } },   // four on the floor to start
+};
+
+static uint8_t track_key[SEQ_TRACKS] = { 0, 2, 4, 7 };
+
+static const uint8_t track_rgb[SEQ_TRACKS][3] = {
+    { 0x20, 0x00, 0x00 },
+    { 0x00, 0x20, 0x00 },
+    { 0x00, 0x00, 0x20 },
+    { 0x20, 0x20, 0x00 },
+};
+
+static uint8_t chain[SEQ_CHAIN_MAX];
+static volatile uint8_t chain_len = 0;
+static uint8_t chain_pos = 0;
+
+static int edit_track = 0;
+static volatile int edit_pattern = 0;
+
+static volatile bool running = false;
+static alarm_id_t alarm_id = 0;
+static uint16_t bpm = 120;
+static volatile uint32_t half_step_us;
+
+// Alarm-side state
+static uint8_t step = 0;
+static uint32_t tick = 0;
+static uint8_t play_pattern = 0;
+
+// Step the alarm last started, and the one currently painted as playhead
+static volatile int8_t led_step = -1;
+static int8_t shown_step = -1;
+
+// Two ticks per step: notes on at the start, off half way (50% gate).
+// Returning a negative delay re-arms relative to the previous target,
+// so scheduling latency never accumulates into tempo drift.
+static int64_t seq_tick(alarm_id_t id, void *user)
+{
+    if (!running) return 0;
+
+    if ((tick & 1) == 0) {
+        play_pattern = chain_len ? chain[chain_pos] : (uint8_t)edit_pattern;
+        const seq_pattern_t *p = &patterns[play_pattern];
+
+        for (int t = 0; t < SEQ_TRACKS; t++)
+            if (p->steps[t] & (1u << step))
+                audio_note_on(SEQ_TAG_BASE + t, tuning_key(track_key[t])->pitch);
+        led_step = (int8_t)step;
+    } else {
+        for (int t = 0; t < SEQ_TRACKS; t++) audio_note_off(SEQ_TAG_BASE + t);
+
+        if (++step == SEQ_STEPS) {
+            step = 0;
+            if (chain_len) chain_pos = (uint8_t)((chain_pos + 1) % chain_len);
+        }
+    }
+
+    tick++;
+    return -(int64_t)half_step_us;
+}
+
+void seq_init(void)
+{
+    seq_set_bpm(bpm);
+}
+
+void seq_start(void)
+{
+    if (running) return;
+    step = 0;
+    tick = 0;
+    chain_pos = 0;
+    running = true;
+    alarm_id = add_alarm_in_us(half_step_us, seq_tick, NULL, true);
+}
+
+void seq_stop(void)
+{
+    if (!running) return;
+    running = false;
+    cancel_alarm(alarm_id);
+    for (int t = 0; t < SEQ_TRACKS; t++) audio_note_off(SEQ_TAG_BASE + t);
+    led_step = -1;
+}
+
+bool seq_running(void)
+{
+    return running;
+}
+
+void seq_set_bpm(uint16_t b)
+{
+    if (b < SEQ_BPM_MIN) b = SEQ_BPM_MIN;
+    if (b > SEQ_BPM_MAX) b = SEQ_BPM_MAX;
+    bpm = b;
+    // 16th notes, two ticks each
+    half_step_us = 60000000u / ((uint32_t)bpm * 8u);
+}
+
+uint16_t seq_bpm(void)
+{
+    return bpm;
+}
+
+void seq_select_track(int track)
+{
+    if (track < 0 || track >= SEQ_TRACKS) return;
+    edit_track = track;
+    seq_redraw();
+}
+
+void seq_select_pattern(int pattern)
+{
+    if (pattern < 0 || pattern >= SEQ_PATTERNS) return;
+    edit_pattern = pattern;
+    seq_redraw();
+}
+
+int seq_track(void)   { return edit_track; }
+int seq_pattern(void) { return edit_pattern; }
+
+void seq_toggle_step(int s)
+{
+    if (s < 0 || s >= SEQ_STEPS) return;
+    patterns[edit_pattern].steps[edit_track] ^= (uint16_t)(1u << s);
+}
+
+void seq_set_track_key(int track, int key)
+{
+    if (track < 0 || track >= SEQ_TRACKS || key < 0 || key >= TUNING_KEYS) return;
+    track_key[track] = (uint8_t)key;
+}
+
+bool seq_chain_append(int pattern)
+{
+    if (pattern < 0 || pattern >= SEQ_PATTERNS || chain_len >= SEQ_CHAIN_MAX) return false;
+    chain[chain_len] = (uint8_t)pattern;
+    chain_len++;
+    return true;
+}
+
+void seq_chain_clear(void)
+{
+    chain_len = 0;
+    chain_pos = 0;
+}
+
+static void paint_step(int s, bool playhead)
+{
+    if (playhead) {
+        neopixel_set_pixel(s, 0x10, 0x10, 0x10);
+    } else if (patterns[edit_pattern].steps[edit_track] & (1u << s)) {
+        const uint8_t *c = track_rgb[edit_track];
+        neopixel_set_pixel(s, c[0], c[1], c[2]);
+    } else {
+        neopixel_set_pixel(s, 0, 0, 0);
+    }
+}
+
+void seq_key(int idx, bool pressed)
+{
+    if (!pressed || (unsigned)idx >= SEQ_STEPS) return;
+    seq_toggle_step(idx);
+    paint_step(idx, idx == shown_step);
+    neopixel_show();
+}
+
+void seq_update_leds(void)
+{
+    int8_t s = led_step;
+    if (s == shown_step) return;
+
+    if (shown_step >= 0) paint_step(shown_step, false);
+    if (s >= 0) paint_step(s, true);
+    shown_step = s;
+    neopixel_show();
+}
+
+void seq_redraw(void)
+{
+    for (int s = 0; s < SEQ_STEPS; s++) paint_step(s, s == shown_step);
+    neopixel_show();
+}
+
+void seq_print(void)
+{
+    printf("[SEQ] %s, %u bpm, pattern %d, track %d (key %d), chain:",
+           running ? "running" : "stopped", bpm, edit_pattern, edit_track, track_key[edit_track]);
+    for (int i = 0; i < chain_len; i++) printf(" %d", chain[i]);
+    printf(chain_len ? "\n" : " none\n");
+}
@@ -0,0 +1,173 @@
+#include "smf.h"
+#include <string.h>
+
+#define SMF_DEFAULT_TEMPO   500000      // 120 bpm
+
+static uint32_t be32(const uint8_t *p) { return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3]; }
+static uint16_t be16(const uint8_t *p) { return (uint16_t)((p[0] << 8) | p[1]); }
+
+// Variable-length quantity, at most 4 bytes. false if it runs off the end.
+static bool read_vlq(const uint8_t **pp, const uint8_t *end, uint32_t *out)
+{
+    const uint8_t *p = *pp;
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) {
+        if (p >= end) return false;
+        uint8_t b = *p++;
+        v = (v << 7) | (b & 0x7F);
+        if (!(b & 0x80)) {
+            *pp = p;
+            *out = v;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool heap_less(const smf_file_t *f, uint8_t a, uint8_t b)
+{
+    uint32_t ta = f->tracks[a].tick, tb = f->tracks[b].tick;
+    return ta < tb || (ta == tb && a < b);      // ties go to the lower track
+}
+
+static void heap_sift_down(smf_file_t *f, uint8_t i)
+{
+    for (;;) {
+        uint8_t l = (uint8_t)(2 * i + 1), r = (uint8_t)(2 * i + 2), m = i;
+        if (l < f->heap_n && heap_less(f, f->heap[l], f->heap[m])) m = l;
+        if (r < f->heap_n && heap_less(f, f->heap[r], f->heap[m])) m = r;
+        if (m == i) return;
+        uint8_t t = f->heap[i]; f->heap[i] = f->heap[m]; f->heap[m] = t;
+        i = m;
+    }
+}
+
+static void heap_push(smf_file_t *f, uint8_t track)
+{
+    uint8_t i = f->heap_n++;
+    f->heap[i] = track;
+    while (i && heap_less(f, f->heap[i], f->heap[(i - 1) / 2])) {
+        uint8_t p = (uint8_t)((i - 1) / 2);
+        uint8_t t = f->heap[i]; f->heap[i] = f->heap[p]; f->heap[p] = t;
+        i = p;
+    }
+}
+
+static void heap_pop(smf_file_t *f)
+{
+    f->heap[0] = f->heap[--f->heap_n];
+    heap_sift_down(f, 0);
+}
+
+smf_err_t smf_open(smf_file_t *f, const uint8_t *data, size_t len)
+{
+    memset(f, 0, sizeof *f);
+    f->data = data;
+    f->len = len;
+    f->tempo = SMF_DEFAULT_TEMPO;
+
+    if (len < 14 || memcmp(data, "MThd", 4) != 0 || be32(data + 4) < 6) return SMF_ERR_HEADER;
+    f->format   = be16(data + 8);
+    f->ntracks  = be16(data + 10);
+    f->division = be16(data + 12);
+    if (f->format > 1 || (f->division & 0x8000) || f->division == 0) return SMF_ERR_FORMAT;
+
+    const uint8_t *p = data + 8 + be32(data + 4);
+    const uint8_t *end = data + len;
+    uint8_t n = 0;
+
+    while (p + 8 <= end && n < f->ntracks && n < SMF_MAX_TRACKS) {
+        uint32_t clen = be32(p + 4);
+        const uint8_t *body = p + 8;
+        if (clen > (size_t)(end - body)) return SMF_ERR_TRUNCATED;
+
+        if (memcmp(p, "MTrk", 4) == 0) {
+            smf_track_t *t = &f->tracks[n];
+            t->pos = body;
+            t->end = body + clen;
+            if (read_vlq(&t->pos, t->end, &t->tick)) heap_push(f, n);
+            n++;
+        }
+        p = body + clen;        // unknown chunks are skipped
+    }
+    f->ntracks = n;
+    return SMF_OK;
+}
+
+// Decodes the event at t->pos. Channel messages honor running status;
+// meta and sysex cancel it, as the spec says.
+static bool read_event(smf_track_t *t, smf_event_t *ev)
+{
+    const uint8_t *p = t->pos;
+    if (p >= t->end) return false;
+
+    uint8_t status = *p;
+    if (status & 0x80) p++;
+    else if (t->running) status = t->running;
+    else return false;
+
+    ev->status = status;
+    ev->data = NULL;
+    ev->len = 0;
+    ev->d1 = ev->d2 = 0;
+
+    if (status < 0xF0) {
+        int n = ((status & 0xE0) == 0xC0) ? 1 : 2;     // program change / channel pressure
+        if (t->end - p < n) return false;
+        ev->d1 = p[0];
+        if (n == 2) ev->d2 = p[1];
+        p += n;
+        t->running = status;
+    } else if (status == 0xFF) {
+        if (p >= t->end) return false;
+        ev->d1 = *p++;
+        if (!read_vlq(&p, t->end, &ev->len) || ev->len > (uint32_t)(t->end - p)) return false;
+        ev->data = p;
+        p += ev->len;
+        t->running = 0;
+    } else if (status == 0xF0 || status == 0xF7) {
+        if (!read_vlq(&p, t->end, &ev->len) || ev->len > (uint32_t)(t->end - p)) return false;
+        ev->data = p;
+        p += ev->len;
+        t->running = 0;
+    } else {
+        return false;
+    }
+
+    t->pos = p;
+    return true;
+}
+
+bool smf_next(smf_file_t *f, smf_event_t *ev)
+{
+    while (f->heap_n) {
+        uint8_t ti = f->heap[0];
+        smf_track_t *t = &f->tracks[ti];
+
+        ev->tick = t->tick;
+        ev->track = ti;
+        bool ok = read_event(t, ev);
+
+        // Queue this track's following event, or retire the track
+        uint32_t delta;
+        bool end_of_track = ok && ev->status == 0xFF && ev->d1 == 0x2F;
+        if (ok && !end_of_track && read_vlq(&t->pos, t->end, &delta)) {
+            t->tick += delta;
+            heap_sift_down(f, 0);
+        } else {
+            heap_pop(f);
+        }
+        if (!ok) continue;      // malformed track: drop the rest of it
+
+        ev->time_us = (uint32_t)(f->tempo_us +
+                      (uint64_t)(ev->tick - f->tempo_tick) * f->tempo / f->division);
+
+        if (ev->status == 0xFF && ev->d1 == 0x51 && ev->len == 3) {
+            f->tempo_us = ev->time_us;
+            f->tempo_tick = ev->tick;
+            f->tempo = ((uint32_t)ev->data[0] << 16) | ((uint32_t)ev->data[1] << 8) | ev->data[2];
+        }
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,131 @@
+#include "smf_player.h"
+#include "smf.h"
+#include "audio.h"
+#include "pico/stdlib.h"
+#include <stdio.h>
+
+#define SMF_DRUM_CHANNEL    9       // GM drums make no sense on a square wave
+#define SMF_LOOP_GAP_US     500000
+
+static smf_file_t file;
+static smf_event_t pending;         // next event to dispatch
+static int cur_song = 0;
+static bool looping = false;
+
+static volatile bool playing = false;
+static alarm_id_t alarm_id = 0;
+static uint64_t start_us;           // song time 0
+static uint64_t target_us;
+
+static uint32_t n_dispatched = 0;
+static uint32_t late_max_us = 0;
+static uint64_t late_sum_us = 0;
+static uint32_t n_callbacks = 0;
+
+static void dispatch(const smf_event_t *ev)
+{
+    if (ev->status >= 0xF0) return;
+    if ((ev->status & 0x0F) == SMF_DRUM_CHANNEL) return;
+
+    uint16_t tag = (uint16_t)(SMF_TAG_BASE | (ev->d1 & 0x7F));
+    if (smf_is_note_on(ev)) {
+        audio_note_on(tag, PITCH_MIDI(ev->d1));
+        n_dispatched++;
+    } else if (smf_is_note_off(ev)) {
+        audio_note_off(tag);
+        n_dispatched++;
+    }
+}
+
+static void notes_off(void)
+{
+    for (int n = 0; n < 128; n++) audio_note_off((uint16_t)(SMF_TAG_BASE | n));
+}
+
+// Dispatches everything due at this target and re-arms for the next event.
+// Targets come from the tempo map, never from "now", so there is no drift.
+static int64_t smf_tick(alarm_id_t id, void *user)
+{
+    if (!playing) return 0;
+
+    uint64_t now_target = target_us;
+    uint32_t late = (uint32_t)(time_us_64() - now_target);
+    if (late > late_max_us) late_max_us = late;
+    late_sum_us += late;
+    n_callbacks++;
+
+    bool more;
+    do {
+        dispatch(&pending);
+        more = smf_next(&file, &pending);
+    } while (more && start_us + pending.time_us <= now_target);
+
+    if (!more) {
+        notes_off();
+        if (!looping || smf_open(&file, smf_songs[cur_song].data, smf_songs[cur_song].len) != SMF_OK ||
+            !smf_next(&file, &pending)) {
+            playing = false;
+            return 0;
+        }
+        start_us = now_target + SMF_LOOP_GAP_US;
+    }
+
+    target_us = start_us + pending.time_us;
+    if (target_us <= now_target) target_us = now_target + 1;
+    return -(int64_t)(target_us - now_target);
+}
+
+bool smf_player_start(int song, bool loop)
+{
+    smf_player_stop();
+    if (song < 0 || song >= smf_song_count) return false;
+
+    smf_err_t err = smf_open(&file, smf_songs[song].data, smf_songs[song].len);
+    if (err != SMF_OK) {
+        printf("[SMF] %s: open failed (%d)\n", smf_songs[song].name, err);
+        return false;
+    }
+    if (!smf_next(&file, &pending)) return false;
+
+    cur_song = song;
+    looping = loop;
+    n_dispatched = 0;
+    late_max_us = 0;
+    late_sum_us = 0;
+    n_callbacks = 0;
+
+    start_us = time_us_64() + 1000;
+    target_us = start_us + pending.time_us;
+    playing = true;
+    alarm_id = add_alarm_at(from_us_since_boot(target_us), smf_tick, NULL, true);
+    return true;
+}
+
+void smf_player_stop(void)
+{
+    if (!playing) return;
+    playing = false;
+    cancel_alarm(alarm_id);
+    notes_off();
+}
+
+bool smf_player_playing(void)
+{
+    return playing;
+}
+
+int smf_player_song(void)
+{
+    return cur_song;
+}
+
+void smf_player_print(void)
+{
+    printf("[SMF] %s: %s, format %u, %u tracks, %u ticks/qn%s\n",
+           smf_songs[cur_song].name, playing ? "playing" : "stopped",
+           file.format, file.ntracks, file.division, looping ? ", looping" : "");
+    if (n_callbacks)
+        printf("[SMF] %lu notes dispatched, lateness avg %lu us, max %lu us\n",
+               (unsigned long)n_dispatched, (unsigned long)(late_sum_us / n_callbacks),
+               (unsigned long)late_max_us);
+}
@@ -0,0 +1,56 @@
+#include "smf_player.h"
+
+// Songs live in flash as plain const arrays; the parser reads them through
+// XIP in place. Format 1 (tempo track + 2 parts, tempo change at bar 5):
+static const uint8_t ode_to_joy_mid[] = {
+    0x4D, 0x54, 0x68, 0x64, 0x00, 0x00, 0x00, 0x06, 0x00, 0x01, 0x00, 0x03,
+    0x00, 0x60, 0x4D, 0x54, 0x72, 0x6B, 0x00, 0x00, 0x00, 0x1A, 0x00, 0xFF,
+    0x51, 0x03, 0x07, 0xA1, 0x20, 0x00, 0xFF, 0x03, 0x03, 0x4F, 0x64, 0x65,
+    0x8C, 0x00, 0xFF, 0x51, 0x03, 0x06, 0x8A, 0x1B, 0x00, 0xFF, 0x2F, 0x00,
+    0x4D, 0x54, 0x72, 0x6B, 0x00, 0x00, 0x00, 0xBD, 0x00, 0x90, 0x40, 0x64,
+    0x58, 0x40, 0x00, 0x08, 0x40, 0x64, 0x58, 0x40, 0x00, 0x08, 0x41, 0x64,
+    0x58, 0x41, 0x00, 0x08, 0x43, 0x64, 0x58, 0x43, 0x00, 0x08, 0x43, 0x64,
+    0x58, 0x43, 0x00, 0x08, 0x41, 0x64, 0x58, 0x41, 0x00, 0x08, 0x40, 0x64,
+    0x58, 0x40, 0x00, 0x08, 0x3E, 0x64, 0x58, 0x3E, 0x00, 0x08, 0x3C, 0x64,
+    0x58, 0x3C, 0x00, 0x08, 0x3C, 0x64, 0x58, 0x3C, 0x00, 0x08, 0x3E, 0x64,
+    0x58, 0x3E, 0x00, 0x08, 0x40, 0x64, 0x58, 0x40, 0x00, 0x08, 0x40, 0x64,
+    0x81, 0x08, 0x40, 0x00, 0x08, 0x3E, 0x64, 0x28, 0x3E, 0x00, 0x08, 0x3E,
+    0x64, 0x81, 0x38, 0x3E, 0x00, 0x08, 0x40, 0x64, 0x58, 0x40, 0x00, 0x08,
+    0x40, 0x64, 0x58, 0x40, 0x00, 0x08, 0x41, 0x64, 0x58, 0x41, 0x00, 0x08,
+    0x43, 0x64, 0x58, 0x43, 0x00, 0x08, 0x43, 0x64, 0x58, 0x43, 0x00, 0x08,
+    0x41, 0x64, 0x58, 0x41, 0x00, 0x08, 0x40, 0x64, 0x58, 0x40, 0x00, 0x08,
+    0x3E, 0x64, 0x58, 0x3E, 0x00, 0x08, 0x3C, 0x64, 0x58, 0x3C, 0x00, 0x08,
+    0x3C, 0x64, 0x58, 0x3C, 0x00, 0x08, 0x3E, 0x64, 0x58, 0x3E, 0x00, 0x08,
+    0x40, 0x64, 0x58, 0x40, 0x00, 0x08, 0x3E, 0x64, 0x81, 0x08, 0x3E, 0x00,
+    0x08, 0x3C, 0x64, 0x28, 0x3C, 0x00, 0x08, 0x3C, 0x64, 0x81, 0x38, 0x3C,
+    0x00, 0x00, 0xFF, 0x2F, 0x00, 0x4D, 0x54, 0x72, 0x6B, 0x00, 0x00, 0x00,
+    0x4B, 0x00, 0x91, 0x30, 0x50, 0x82, 0x78, 0x30, 0x00, 0x08, 0x2B, 0x50,
+    0x82, 0x78, 0x2B, 0x00, 0x08, 0x30, 0x50, 0x82, 0x78, 0x30, 0x00, 0x08,
+    0x2B, 0x50, 0x81, 0x38, 0x2B, 0x00, 0x08, 0x2B, 0x50, 0x81, 0x38, 0x2B,
+    0x00, 0x08, 0x30, 0x50, 0x82, 0x78, 0x30, 0x00, 0x08, 0x2B, 0x50, 0x82,
+    0x78, 0x2B, 0x00, 0x08, 0x30, 0x50, 0x81, 0x38, 0x30, 0x00, 0x08, 0x2B,
+    0x50, 0x81, 0x38, 0x2B, 0x00, 0x08, 0x30, 0x50, 0x82, 0x78, 0x30, 0x00,
+    0x00, 0xFF, 0x2F, 0x00,
+};
+
+// Format 0, one track with running status:
+static const uint8_t scale_mid[] = {
+    0x4D, 0x54, 0x68, 0x64, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 0x01,
+    0x00, 0x60, 0x4D, 0x54, 0x72, 0x6B, 0x00, 0x00, 0x00, 0x66, 0x00, 0xFF,
+    0x51, 0x03, 0x06, 0x1A, 0x80, 0x00, 0x90, 0x3C, 0x64, 0x28, 0x3C, 0x00,
+    0x08, 0x3E, 0x64, 0x28, 0x3E, 0x00, 0x08, 0x40, 0x64, 0x28, 0x40, 0x00,
+    0x08, 0x41, 0x64, 0x28, 0x41, 0x00, 0x08, 0x43, 0x64, 0x28, 0x43, 0x00,
+    0x08, 0x45, 0x64, 0x28, 0x45, 0x00, 0x08, 0x47, 0x64, 0x28, 0x47, 0x00,
+    0x08, 0x48, 0x64, 0x28, 0x48, 0x00, 0x08, 0x47, 0x64, 0x28, 0x47, 0x00,
+    0x08, 0x45, 0x64, 0x28, 0x45, 0x00, 0x08, 0x43, 0x64, 0x28, 0x43, 0x00,
+    0x08, 0x41, 0x64, 0x28, 0x41, 0x00, 0x08, 0x40, 0x64, 0x28, 0x40, 0x00,
+    0x08, 0x3E, 0x64, 0x28, 0x3E, 0x00, 0x08, 0x3C, 0x64, 0x28, 0x3C, 0x00,
+    0x00, 0xFF, 0x2F, 0x00,
+};
+
+const smf_song_t smf_songs[] = {
+    { "ode to joy", ode_to_joy_mid, sizeof ode_to_joy_mid },
+    { "scale",      scale_mid,      sizeof scale_mid },
+};
+
+const int smf_song_count = sizeof smf_songs / sizeof smf_songs[0];
@@ -0,0 +1,9 @@
+#include "spsc.h"
+#include <stdio.h>
+
+void spsc_print(const char *name, const spsc_t *q)
+{
+    printf("  %-8s %2lu/%-3u queued, high water %lu, %lu dropped\n", name,
+           (unsigned long)spsc_count(q), q->mask + 1u,
+           (unsigned long)q->hwm, (unsigned long)q->dropped);
+}
@@ -0,0 +1,132 @@
+#include "tuning.h"
+#include "audio.h"
+#include <stdio.h>
+#include <string.h>
+
+typedef struct {
+    const char *name;
+    uint8_t steps[TUNING_USER_MAX];     // semitones above the root
+    uint8_t n;
+} scale_def_t;
+
+static scale_def_t scales[SCALE_COUNT] = {
+    [SCALE_MAJOR]      = { "major",      { 0, 2, 4, 5, 7, 9, 11 }, 7 },
+    [SCALE_MINOR]      = { "minor",      { 0, 2, 3, 5, 7, 8, 10 }, 7 },
+    [SCALE_CHROMATIC]  = { "chromatic",  { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 }, 12 },
+    [SCALE_PENTATONIC] = { "pentatonic", { 0, 2, 4, 7, 9 }, 5 },
+    [SCALE_USER]       = { "user",       { 0, 3, 5, 6, 7, 10 }, 6 },   // blues until set
+};
+
+// Deviation from equal temperament per interval above the root, in 1/100 cent.
+static const int16_t temper_cc[TEMPER_COUNT][12] = {
+    [TEMPER_EQUAL]       = { 0 },
+    [TEMPER_JUST]        = { 0,  1173,   391,  1564, -1369,  -196,
+                             -978,  196, 1369, -1564,  1760, -1173 },
+    [TEMPER_PYTHAGOREAN] = { 0,  -978,   391,  -587,   782,  -196,
+                             1173,  196, -782,   587,  -391,   978 },
+    [TEMPER_MEANTONE]    = { 0, -2395,  -684,  1026, -1369,   342,
+                            -2053, -342, -2737, -1026,   684, -1711 },
+};
+
+static const char *temper_names[TEMPER_COUNT] = {
+    "equal", "just", "pythagorean", "meantone"
+};
+
+static const char *pc_names[12] = {
+    "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B"
+};
+
+tuning_key_t tuning_table[TUNING_KEYS];
+
+static scale_t cur_scale = SCALE_MAJOR;
+static uint8_t cur_root = 0;
+static int8_t cur_octave = 0;
+static temperament_t cur_temper = TEMPER_EQUAL;
+
+static void tuning_rebuild(void)
+{
+    const scale_def_t *s = &scales[cur_scale];
+    int base = 12 * (4 + 1 + cur_octave) + cur_root;     // C4 == MIDI 60
+
+    for (int k = 0; k < TUNING_KEYS; k++) {
+        int semis = s->steps[k % s->n] + 12 * (k / s->n);
+        int note = base + semis;
+        if (note > 127) note = 127;
+
+        tuning_key_t *t = &tuning_table[k];
+        t->note = (uint8_t)note;
+        t->pitch = PITCH_MIDI(note) + temper_cc[cur_temper][semis % 12] * PITCH_CENT / 100;
+        t->inc = pitch_to_inc(t->pitch);
+        t->hz = (uint16_t)(((uint64_t)t->inc * AUDIO_SAMPLE_RATE + (1ull << 31)) >> 32);
+        snprintf(t->name, sizeof t->name, "%s%d", pc_names[note % 12], note / 12 - 1);
+    }
+}
+
+void tuning_init(void)
+{
+    tuning_rebuild();
+}
+
+void tuning_set_scale(scale_t scale)
+{
+    if (scale >= SCALE_COUNT) return;
+    cur_scale = scale;
+    tuning_rebuild();
+}
+
+void tuning_set_root(uint8_t semitone)
+{
+    cur_root = semitone % 12;
+    tuning_rebuild();
+}
+
+void tuning_set_octave(int8_t shift)
+{
+    if (shift < -3) shift = -3;
+    if (shift > 3) shift = 3;
+    cur_octave = shift;
+    tuning_rebuild();
+}
+
+void tuning_set_temperament(temperament_t t)
+{
+    if (t >= TEMPER_COUNT) return;
+    cur_temper = t;
+    tuning_rebuild();
+}
+
+bool tuning_set_user_scale(const uint8_t *steps, uint8_t n)
+{
+    if (n == 0 || n > TUNING_USER_MAX) return false;
+    for (uint8_t i = 0; i < n; i++) {
+        if (steps[i] > 11) return false;
+        if (i && steps[i] <= steps[i - 1]) return false;     // must ascend
+    }
+    memcpy(scales[SCALE_USER].steps, steps, n);
+    scales[SCALE_USER].n = n;
+    if (cur_scale == SCALE_USER) tuning_rebuild();
+    return true;
+}
+
+scale_t       tuning_scale(void)       { return cur_scale; }
+uint8_t       tuning_root(void)        { return cur_root; }
+int8_t        tuning_octave(void)      { return cur_octave; }
+temperament_t tuning_temperament(void) { return cur_temper; }
+
+const char *tuning_scale_name(scale_t scale)
+{
+    return scale < SCALE_COUNT ? scales[scale].name : "?";
+}
+
+const char *tuning_temperament_name(temperament_t t)
+{
+    return t < TEMPER_COUNT ? temper_names[t] : "?";
+}
+
+void tuning_print(void)
+{
+    printf("[TUNE] %s %s, octave %+d, %s\n", pc_names[cur_root],
+           scales[cur_scale].name, cur_octave, temper_names[cur_temper]);
+    for (int k = 0; k < TUNING_KEYS; k++)
+        printf("  key %2d: %-4s %5u Hz\n", k, tuning_table[k].name, tuning_table[k].hz);
+}
@@ -0,0 +1,226 @@
+#include "uart_midi.h"
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/uart.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "midi_in.h"
+
+// RX ring: 256 bytes is ~80 ms of back-to-back MIDI
+#define RX_RING_BITS    8
+#define RX_RING_SIZE    (1u << RX_RING_BITS)
+#define RX_RING_MASK    (RX_RING_SIZE - 1)
+
+#define TX_BATCH        64
+
+static uint8_t rx_ring[RX_RING_SIZE] __attribute__((aligned(RX_RING_SIZE)));
+static int rx_dma;
+static uint32_t rx_tail = 0;                // next byte to parse
+static volatile uint32_t rx_ready = 0;      // published by the idle timer
+static uint32_t rx_seen = 0;                // DMA position at the last tick
+static uint32_t rx_wakes = 0;               // idle timer runs
+static midi_parser_t rx_parser;
+
+static uint8_t tx_buf[2][TX_BATCH];
+static uint8_t tx_len[2];
+static uint8_t tx_fill = 0;                 // buffer being packed
+static uint8_t tx_running = 0;
+static int tx_dma;
+
+static uint32_t rx_bytes = 0;
+static uint32_t tx_bytes = 0;
+static uint32_t tx_batches = 0;
+static uint32_t tx_dropped = 0;
+
+// loopback self-test
+static const uint8_t loop_notes[] = { 60, 62, 64, 65, 67, 69, 71, 72 };
+#define LOOP_MSGS       (2 * (int)sizeof(loop_notes))
+static bool loop_active = false;
+static int loop_rx = 0;
+static int loop_ok = 0;
+
+static inline uint32_t rx_head(void)
+{
+    return (uint32_t)((uintptr_t)dma_hw->ch[rx_dma].write_addr - (uintptr_t)rx_ring) & RX_RING_MASK;
+}
+
+// Publishes the ring position once the DMA write pointer has stopped
+// moving for a whole period, i.e. a burst of messages is complete, then
+// hands back to the start-bit edge. Enabling the edge clears any latched
+// one, so a line already low (a start bit that just began) keeps the
+// timer going instead.
+static int64_t rx_idle_tick(alarm_id_t id, void *user)
+{
+    uint32_t head = rx_head();
+
+    rx_wakes++;
+    if (head == rx_seen) {
+        rx_ready = head;
+        gpio_set_irq_enabled(UART_MIDI_RX_PIN, GPIO_IRQ_EDGE_FALL, true);
+        if (gpio_get(UART_MIDI_RX_PIN)) return 0;
+        gpio_set_irq_enabled(UART_MIDI_RX_PIN, GPIO_IRQ_EDGE_FALL, false);
+    }
+    rx_seen = head;
+    return -UART_MIDI_IDLE_US;
+}
+
+// The RX pin still feeds the GPIO edge detector under the UART function.
+// A start bit on a quiet line arms the idle timer; the edge is off while
+// the timer runs, so the line costs no wake-ups while it is idle.
+static void rx_edge_irq(void)
+{
+    if (!(gpio_get_irq_event_mask(UART_MIDI_RX_PIN) & GPIO_IRQ_EDGE_FALL)) return;
+    gpio_acknowledge_irq(UART_MIDI_RX_PIN, GPIO_IRQ_EDGE_FALL);
+    if (add_alarm_in_us(UART_MIDI_IDLE_US, rx_idle_tick, NULL, true) < 0) return;   // next edge retries
+    gpio_set_irq_enabled(UART_MIDI_RX_PIN, GPIO_IRQ_EDGE_FALL, false);
+}
+
+void uart_midi_init(void)
+{
+    uart_init(UART_MIDI_ID, UART_MIDI_BAUD);
+    uart_set_format(UART_MIDI_ID, 8, 1, UART_PARITY_NONE);
+    uart_set_hw_flow(UART_MIDI_ID, false, false);
+    uart_set_fifo_enabled(UART_MIDI_ID, true);
+    gpio_set_function(UART_MIDI_TX_PIN, GPIO_FUNC_UART);
+    gpio_set_function(UART_MIDI_RX_PIN, GPIO_FUNC_UART);
+
+    uart_hw_t *hw = uart_get_hw(UART_MIDI_ID);
+    hw->dmacr = UART_UARTDMACR_RXDMAE_BITS | UART_UARTDMACR_TXDMAE_BITS;
+
+    midi_parser_reset(&rx_parser);
+
+    // RX: data register into the ring, wrapping forever
+    rx_dma = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(rx_dma);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_ring(&c, true, RX_RING_BITS);
+    channel_config_set_dreq(&c, uart_get_dreq(UART_MIDI_ID, false));
+    dma_channel_configure(rx_dma, &c, rx_ring, &hw->dr, 0, false);
+    dma_channel_set_trans_count(rx_dma, 0xFFFFFFFF, true);
+
+    // TX: one transfer per batch, started from uart_midi_task
+    tx_dma = dma_claim_unused_channel(true);
+    c = dma_channel_get_default_config(tx_dma);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, uart_get_dreq(UART_MIDI_ID, true));
+    dma_channel_configure(tx_dma, &c, &hw->dr, tx_buf[0], 0, false);
+
+    gpio_add_raw_irq_handler(UART_MIDI_RX_PIN, rx_edge_irq);
+    gpio_set_irq_enabled(UART_MIDI_RX_PIN, GPIO_IRQ_EDGE_FALL, true);
+    irq_set_enabled(IO_IRQ_BANK0, true);
+
+    printf("[UART MIDI] %u baud, TX GPIO %d, RX GPIO %d\n",
+           UART_MIDI_BAUD, UART_MIDI_TX_PIN, UART_MIDI_RX_PIN);
+}
+
+static void uart_midi_handle(const midi_msg_t *m)
+{
+    if (loop_active) {
+        if (loop_rx < LOOP_MSGS) {
+            int i = loop_rx++;
+            midi_msg_t want = midi_note(MIDI_CHANNEL, loop_notes[i / 2], (i & 1) ? 0 : 100, true);
+            if (m->status == want.status && m->d1 == want.d1 && m->d2 == want.d2) loop_ok++;
+        }
+        return;
+    }
+    midi_in_dispatch(m);
+}
+
+static inline uint32_t rx_pending(void)
+{
+    return (rx_head() - rx_tail) & RX_RING_MASK;
+}
+
+// Parses n bytes straight out of the DMA ring.
+static void rx_parse(uint32_t n)
+{
+    midi_msg_t m;
+
+    rx_bytes += n;
+    while (n--) {
+        if (midi_parse_byte(&rx_parser, rx_ring[rx_tail], &m)) uart_midi_handle(&m);
+        rx_tail = (rx_tail + 1) & RX_RING_MASK;
+    }
+}
+
+static void tx_kick(void)
+{
+    if (tx_len[tx_fill] == 0 || dma_channel_is_busy(tx_dma)) return;
+
+    dma_channel_transfer_from_buffer_now(tx_dma, tx_buf[tx_fill], tx_len[tx_fill]);
+    tx_bytes += tx_len[tx_fill];
+    tx_batches++;
+
+    tx_fill ^= 1;
+    tx_len[tx_fill] = 0;
+    tx_running = 0;         // every batch starts with a full status byte
+}
+
+void uart_midi_task(void)
+{
+    uint32_t avail = rx_pending();
+    uint32_t ready = (rx_ready - rx_tail) & RX_RING_MASK;
+
+    if (ready > avail) ready = 0;               // published before we last caught up
+    if (avail >= RX_RING_SIZE / 2) ready = avail;   // a gapless stream never idles
+
+    rx_parse(ready);
+    tx_kick();
+}
+
+bool uart_midi_send(const midi_msg_t *m)
+{
+    uint8_t f = tx_fill;
+
+    if (tx_len[f] > TX_BATCH - 3) {
+        tx_dropped++;
+        return false;
+    }
+    tx_len[f] = (uint8_t)(tx_len[f] + midi_encode(m, &tx_buf[f][tx_len[f]], &tx_running));
+    return true;
+}
+
+void uart_midi_send_note(uint8_t note, uint8_t velocity, bool on)
+{
+    midi_msg_t m = midi_note(MIDI_CHANNEL, note, on ? velocity : 0, true);
+    uart_midi_send(&m);
+}
+
+void uart_midi_loopback_test(void)
+{
+    // drain whatever is already in flight so it isn't counted
+    uart_midi_task();
+    rx_parse(rx_pending());
+
+    loop_rx = 0;
+    loop_ok = 0;
+    loop_active = true;
+
+    uint32_t bytes0 = tx_bytes;
+    for (unsigned i = 0; i < sizeof(loop_notes); i++) {
+        uart_midi_send_note(loop_notes[i], 100, true);
+        uart_midi_send_note(loop_notes[i], 0, false);
+    }
+
+    uint32_t t0 = time_us_32();
+    while (loop_rx < LOOP_MSGS && time_us_32() - t0 < 50000) {
+        uart_midi_task();
+        rx_parse(rx_pending());
+    }
+    uint32_t dt = time_us_32() - t0;
+    loop_active = false;
+
+    printf("[UART MIDI] loopback: %d/%d messages ok, %lu bytes (running status), %lu us\n",
+           loop_ok, LOOP_MSGS, (unsigned long)(tx_bytes - bytes0), (unsigned long)dt);
+}
+
+void uart_midi_print(void)
+{
+    printf("[UART MIDI] rx %lu bytes (%lu idle timer wakes), tx %lu bytes in %lu batches, %lu tx drops\n",
+           (unsigned long)rx_bytes, (unsigned long)rx_wakes, (unsigned long)tx_bytes,
+           (unsigned long)tx_batches, (unsigned long)tx_dropped);
+}
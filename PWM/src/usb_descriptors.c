@@ -0,0 +1,107 @@
+#include <string.h>
+#include "tusb.h"
+#include "pico/unique_id.h"
+
+// Composite CDC + MIDI device. The PID differs from the SDK's CDC-only one
+// so hosts do not reuse a cached single-interface configuration.
+#define USBD_VID            0x2E8A      // Raspberry Pi
+#define USBD_PID            0x4011
+#define USBD_MAX_POWER_MA   250
+
+enum {
+    ITF_NUM_CDC = 0,
+    ITF_NUM_CDC_DATA,
+    ITF_NUM_MIDI,
+    ITF_NUM_MIDI_STREAMING,
+    ITF_NUM_TOTAL
+};
+
+#define EPNUM_CDC_NOTIF     0x81
+#define EPNUM_CDC_OUT       0x02
+#define EPNUM_CDC_IN        0x82
+#define EPNUM_MIDI_OUT      0x03
+#define EPNUM_MIDI_IN       0x83
+
+#define CONFIG_TOTAL_LEN    (TUD_CONFIG_DESC_LEN + TUD_CDC_DESC_LEN + TUD_MIDI_DESC_LEN)
+
+enum {
+    STRID_LANGID = 0,
+    STRID_MANUFACTURER,
+    STRID_PRODUCT,
+    STRID_SERIAL,
+    STRID_CDC,
+    STRID_MIDI,
+};
+
+static const tusb_desc_device_t desc_device = {
+    .bLength            = sizeof(tusb_desc_device_t),
+    .bDescriptorType    = TUSB_DESC_DEVICE,
+    .bcdUSB             = 0x0200,
+    // IAD so the host groups the two CDC interfaces
+    .bDeviceClass       = TUSB_CLASS_MISC,
+    .bDeviceSubClass    = MISC_SUBCLASS_COMMON,
+    .bDeviceProtocol    = MISC_PROTOCOL_IAD,
+    .bMaxPacketSize0    = CFG_TUD_ENDPOINT0_SIZE,
+    .idVendor           = USBD_VID,
+    .idProduct          = USBD_PID,
+    .bcdDevice          = 0x0100,
+    .iManufacturer      = STRID_MANUFACTURER,
+    .iProduct           = STRID_PRODUCT,
+    .iSerialNumber      = STRID_SERIAL,
+    .bNumConfigurations = 1
+};
+
+static const uint8_t desc_config[] = {
+    TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, CONFIG_TOTAL_LEN, 0, USBD_MAX_POWER_MA),
+    TUD_CDC_DESCRIPTOR(ITF_NUM_CDC, STRID_CDC, EPNUM_CDC_NOTIF, 8, EPNUM_CDC_OUT, EPNUM_CDC_IN, 64),
+    TUD_MIDI_DESCRIPTOR(ITF_NUM_MIDI, STRID_MIDI, EPNUM_MIDI_OUT, EPNUM_MIDI_IN, 64),
+};
+
+static const char *const desc_strings[] = {
+    [STRID_MANUFACTURER] = "362 Project",
+    [STRID_PRODUCT]      = "NeoTrellis Synth",
+    [STRID_SERIAL]       = NULL,        // board unique id
+    [STRID_CDC]          = "Synth Console",
+    [STRID_MIDI]         = "Synth MIDI",
+};
+
+const uint8_t *tud_descriptor_device_cb(void)
+{
+    return (const uint8_t *)&desc_device;
+}
+
+const uint8_t *tud_descriptor_configuration_cb(uint8_t index)
+{
+    (void)index;
+    return desc_config;
+}
+
+const uint16_t *tud_descriptor_string_cb(uint8_t index, uint16_t langid)
+{
+    static uint16_t desc_str[33];
+    char serial[2 * 8 + 1];
+    const char *str;
+    uint8_t len;
+
+    (void)langid;
+
+    if (index == STRID_LANGID) {
+        desc_str[1] = 0x0409;           // English
+        len = 1;
+    } else {
+        if (index >= TU_ARRAY_SIZE(desc_strings)) return NULL;
+        if (index == STRID_SERIAL) {
+            pico_get_unique_board_id_string(serial, sizeof(serial));
+            str = serial;
+        } else {
+            str = desc_strings[index];
+        }
+
+        len = (uint8_t)strlen(str);
+        if (len > 32) len = 32;
+        for (uint8_t i = 0; i < len; i++) desc_str[1 + i] = (uint8_t)str[i];
+    }
+
+    desc_str[0] = (uint16_t)((TUSB_DESC_STRING << 8) | (2 * len + 2));
+    return desc_str;
+}
@@ -0,0 +1,49 @@
+#include "usb_midi.h"
+#include <stdio.h>
+#include "tusb.h"
+#include "midi_in.h"
+#include "audio.h"
+
+#define USB_MIDI_CABLE  0
+
+static uint32_t tx_notes = 0;
+static uint32_t tx_dropped = 0;
+
+void usb_midi_init(void)
+{
+    tusb_init();
+}
+
+void usb_midi_task(void)
+{
+    uint8_t pkt[4];
+    midi_msg_t m;
+
+    tud_task();
+
+    while (tud_midi_available() && tud_midi_packet_read(pkt)) {
+        if (midi_from_usb(pkt, &m)) midi_in_dispatch(&m);
+    }
+}
+
+void usb_midi_send_note(uint8_t note, uint8_t velocity, bool on)
+{
+    uint8_t pkt[4];
+    midi_msg_t m = midi_note(MIDI_CHANNEL, note, velocity, on);
+
+    if (!tud_midi_mounted()) return;
+
+    midi_to_usb(&m, USB_MIDI_CABLE, pkt);
+    if (tud_midi_packet_write(pkt)) tx_notes++;
+    else tx_dropped++;
+}
+
+void usb_midi_print(void)
+{
+    printf("[USB MIDI] %s, tx %lu notes, %lu tx drops\n",
+           tud_midi_mounted() ? "mounted" : "not mounted",
+           (unsigned long)tx_notes, (unsigned long)tx_dropped);
+    printf("[MIDI IN] %lu msgs, %lu notes, %lu queue drops\n",
+           (unsigned long)midi_in_messages(), (unsigned long)midi_in_notes(),
+           (unsigned long)audio_post_dropped());
+}
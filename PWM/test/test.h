@@ -0,0 +1,27 @@
+#pragma once
+#include <stdio.h>
+
+// Minimal host-side checks: a failed CHECK reports and carries on, and
+// TEST_DONE turns the count into the exit status.
+static int test_failures = 0;
+
+#define CHECK(cond) do {                                                    \
+        if (!(cond)) {                                                      \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            test_failures++;                                                \
+        }                                                                   \
+    } while (0)
+
+#define CHECK_EQ(a, b) do {                                                 \
+        long long a_ = (long long)(a), b_ = (long long)(b);                 \
+        if (a_ != b_) {                                                     \
+            printf("%s:%d: %s == %lld, expected %lld\n",                    \
+                   __FILE__, __LINE__, #a, a_, b_);                         \
+            test_failures++;                                                \
+        }                                                                   \
+    } while (0)
+
+#define TEST_DONE(name) do {                                                \
+        printf("%s: %s\n", name, test_failures ? "FAILED" : "ok");          \
+        return test_failures ? 1 : 0;                                       \
+    } while (0)
@@ -0,0 +1,167 @@
+#include <string.h>
+#include "midi.h"
+#include "test.h"
+
+// Feeds bytes through one parser; returns the number of messages out.
+static int parse(midi_parser_t *p, const uint8_t *b, int n, midi_msg_t *out, int max)
+{
+    int got = 0;
+    for (int i = 0; i < n; i++) {
+        midi_msg_t m;
+        if (midi_parse_byte(p, b[i], &m) && got < max) out[got++] = m;
+    }
+    return got;
+}
+
+static void check_msg(const midi_msg_t *m, uint8_t status, uint8_t d1, uint8_t d2, uint8_t len)
+{
+    CHECK_EQ(m->status, status);
+    CHECK_EQ(m->d1, d1);
+    CHECK_EQ(m->d2, d2);
+    CHECK_EQ(m->len, len);
+}
+
+static void test_running_status(void)
+{
+    const uint8_t in[] = { 0x90, 0x3C, 0x64, 0x3E, 0x64, 0x3C, 0x00, 0xC1, 0x05, 0x06 };
+    midi_parser_t p;
+    midi_msg_t m[8];
+
+    midi_parser_reset(&p);
+    CHECK_EQ(parse(&p, in, sizeof in, m, 8), 5);
+    check_msg(&m[0], 0x90, 0x3C, 0x64, 3);
+    check_msg(&m[1], 0x90, 0x3E, 0x64, 3);
+    check_msg(&m[2], 0x90, 0x3C, 0x00, 3);
+    check_msg(&m[3], 0xC1, 0x05, 0x00, 2);     // two-byte message runs on too
+    check_msg(&m[4], 0xC1, 0x06, 0x00, 2);
+    CHECK(midi_is_note_off(&m[2]));
+}
+
+static void test_realtime_mid_message(void)
+{
+    // clock between status and data, and between the two data bytes
+    const uint8_t in[] = { 0x90, 0xF8, 0x40, 0xFE, 0x64, 0x41, 0xFA, 0x64 };
+    midi_parser_t p;
+    midi_msg_t m[8];
+
+    midi_parser_reset(&p);
+    CHECK_EQ(parse(&p, in, sizeof in, m, 8), 5);
+    check_msg(&m[0], 0xF8, 0, 0, 1);
+    check_msg(&m[1], 0xFE, 0, 0, 1);
+    check_msg(&m[2], 0x90, 0x40, 0x64, 3);
+    check_msg(&m[3], 0xFA, 0, 0, 1);
+    check_msg(&m[4], 0x90, 0x41, 0x64, 3);     // running status survived
+}
+
+static void test_sysex_skipped(void)
+{
+    const uint8_t in[] = {
+        0x90, 0x3C, 0x64,
+        0xF0, 0x7E, 0x01, 0xF8, 0x06, 0x02, 0xF7,   // real-time still gets out
+        0x3E, 0x64,                                 // sysex cancelled running status
+        0x80, 0x3C, 0x00,
+    };
+    midi_parser_t p;
+    midi_msg_t m[8];
+
+    midi_parser_reset(&p);
+    CHECK_EQ(parse(&p, in, sizeof in, m, 8), 3);
+    check_msg(&m[0], 0x90, 0x3C, 0x64, 3);
+    check_msg(&m[1], 0xF8, 0, 0, 1);
+    check_msg(&m[2], 0x80, 0x3C, 0x00, 3);
+}
+
+static void test_system_common(void)
+{
+    const uint8_t in[] = { 0xF2, 0x10, 0x20, 0xF6, 0xF3, 0x02, 0x05 };
+    midi_parser_t p;
+    midi_msg_t m[8];
+
+    midi_parser_reset(&p);
+    CHECK_EQ(parse(&p, in, sizeof in, m, 8), 3);   // the stray 0x05 is dropped
+    check_msg(&m[0], 0xF2, 0x10, 0x20, 3);
+    check_msg(&m[1], 0xF6, 0, 0, 1);
+    check_msg(&m[2], 0xF3, 0x02, 0, 2);
+}
+
+static void test_encode_running_status(void)
+{
+    const midi_msg_t msgs[] = {
+        midi_note(0, 0x3C, 100, true),
+        midi_note(0, 0x3E, 100, true),
+        { 0xF8, 0, 0, 1 },                      // real-time leaves running status
+        midi_note(0, 0x3C, 0, true),
+        midi_note(0, 0x3E, 0, false),
+        { 0xC0, 0x05, 0, 2 },
+        { 0xC0, 0x06, 0, 2 },
+        { 0xF2, 0x01, 0x02, 3 },                // system common cancels it
+        { 0xC0, 0x07, 0, 2 },
+    };
+    const size_t want[] = { 3, 2, 1, 2, 3, 2, 1, 3, 2 };
+    uint8_t running = 0;
+    uint8_t out[3];
+
+    for (size_t i = 0; i < sizeof msgs / sizeof msgs[0]; i++) {
+        CHECK_EQ(midi_encode(&msgs[i], out, &running), want[i]);
+    }
+    CHECK_EQ(running, 0xC0);
+
+    // without running status every message carries its status byte
+    CHECK_EQ(midi_encode(&msgs[1], out, NULL), 3);
+    CHECK_EQ(out[0], 0x90);
+    CHECK_EQ(out[1], 0x3E);
+    CHECK_EQ(out[2], 100);
+
+    // sysex and undefined statuses are not encoded
+    midi_msg_t sx = { 0xF0, 0, 0, 1 };
+    CHECK_EQ(midi_encode(&sx, out, &running), 0);
+}
+
+static void test_usb_round_trip(void)
+{
+    const struct {
+        midi_msg_t m;
+        uint8_t    cin;
+    } cases[] = {
+        { midi_note(3, 0x40, 0x7F, true),  0x9 },
+        { midi_note(0, 0x40, 0, false),    0x8 },
+        { { 0xA2, 0x40, 0x10, 3 },         0xA },
+        { { 0xB0, 0x07, 0x64, 3 },         0xB },
+        { { 0xC5, 0x12, 0, 2 },            0xC },
+        { { 0xD1, 0x33, 0, 2 },            0xD },
+        { { 0xEF, 0x00, 0x40, 3 },         0xE },
+        { { 0xF2, 0x10, 0x20, 3 },         0x3 },
+        { { 0xF3, 0x04, 0, 2 },            0x2 },
+        { { 0xF6, 0, 0, 1 },               0x5 },
+        { { 0xF8, 0, 0, 1 },               0xF },
+        { { 0xFC, 0, 0, 1 },               0xF },
+    };
+
+    for (size_t i = 0; i < sizeof cases / sizeof cases[0]; i++) {
+        uint8_t pkt[4];
+        midi_msg_t back;
+
+        midi_to_usb(&cases[i].m, 1, pkt);
+        CHECK_EQ(pkt[0], 0x10 | cases[i].cin);
+        CHECK(midi_from_usb(pkt, &back));
+        check_msg(&back, cases[i].m.status, cases[i].m.d1, cases[i].m.d2, cases[i].m.len);
+    }
+
+    // sysex packets (CIN 4..7) and reserved codes are not messages
+    const uint8_t sysex[4] = { 0x04, 0xF0, 0x7E, 0x01 };
+    const uint8_t misc[4]  = { 0x00, 0x90, 0x40, 0x40 };
+    midi_msg_t m;
+    CHECK(!midi_from_usb(sysex, &m));
+    CHECK(!midi_from_usb(misc, &m));
+}
+
+int main(void)
+{
+    test_running_status();
+    test_realtime_mid_message();
+    test_sysex_skipped();
+    test_system_common();
+    test_encode_running_status();
+    test_usb_round_trip();
+    TEST_DONE("test_midi");
+}
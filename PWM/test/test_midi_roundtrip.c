@@ -0,0 +1,97 @@
+#include <string.h>
+#include "midi.h"
+#include "test.h"
+
+// The DIN transport packs messages with running status and parses the
+// receive ring one byte at a time; what comes out must be what went in.
+
+#define N_MSGS  512
+
+static uint32_t seed = 12345;
+
+static uint32_t rnd(uint32_t n)
+{
+    seed = seed * 1103515245u + 12345u;
+    return (seed >> 16) % n;
+}
+
+static midi_msg_t random_msg(void)
+{
+    uint8_t ch = (uint8_t)rnd(2);               // two channels break the runs up
+
+    switch (rnd(8)) {
+        case 0:  return (midi_msg_t){ 0xF8, 0, 0, 1 };
+        case 1:  return (midi_msg_t){ (uint8_t)(0xB0 | ch), (uint8_t)rnd(128), (uint8_t)rnd(128), 3 };
+        case 2:  return (midi_msg_t){ (uint8_t)(0xC0 | ch), (uint8_t)rnd(128), 0, 2 };
+        default: return midi_note(ch, (uint8_t)(48 + rnd(24)), (uint8_t)rnd(128), rnd(2));
+    }
+}
+
+static void test_note_stream(void)
+{
+    static midi_msg_t sent[N_MSGS], got[N_MSGS];
+    static uint8_t wire[N_MSGS * 3];
+    uint8_t running = 0;
+    size_t n = 0;
+
+    for (int i = 0; i < N_MSGS; i++) {
+        sent[i] = random_msg();
+        n += midi_encode(&sent[i], wire + n, &running);
+    }
+    CHECK(n < (size_t)N_MSGS * 3);              // running status saved something
+
+    midi_parser_t p;
+    int count = 0;
+    midi_parser_reset(&p);
+    for (size_t i = 0; i < n; i++) {
+        midi_msg_t m;
+        if (midi_parse_byte(&p, wire[i], &m)) {
+            if (count < N_MSGS) got[count] = m;
+            count++;
+        }
+    }
+
+    CHECK_EQ(count, N_MSGS);
+    for (int i = 0; i < N_MSGS && i < count; i++) {
+        if (memcmp(&sent[i], &got[i], sizeof sent[i]) != 0) {
+            printf("message %d: sent %02X %02X %02X, got %02X %02X %02X\n", i,
+                   sent[i].status, sent[i].d1, sent[i].d2, got[i].status, got[i].d1, got[i].d2);
+            test_failures++;
+            break;
+        }
+    }
+    printf("  %d messages in %zu bytes\n", N_MSGS, n);
+}
+
+// A run of note-ons on one channel is sent as one status byte and pairs.
+static void test_note_run(void)
+{
+    uint8_t wire[64], running = 0;
+    size_t n = 0;
+
+    for (int k = 0; k < 16; k++) {
+        midi_msg_t m = midi_note(0, (uint8_t)(60 + k), (uint8_t)(k & 1 ? 0 : 100), true);
+        n += midi_encode(&m, wire + n, &running);
+    }
+    CHECK_EQ(n, 1 + 16 * 2);
+
+    midi_parser_t p;
+    int k = 0;
+    midi_parser_reset(&p);
+    for (size_t i = 0; i < n; i++) {
+        midi_msg_t m;
+        if (!midi_parse_byte(&p, wire[i], &m)) continue;
+        CHECK_EQ(m.status, 0x90);
+        CHECK_EQ(m.d1, 60 + k);
+        CHECK_EQ(m.d2, k & 1 ? 0 : 100);
+        k++;
+    }
+    CHECK_EQ(k, 16);
+}
+
+int main(void)
+{
+    test_note_stream();
+    test_note_run();
+    TEST_DONE("test_midi_roundtrip");
+}
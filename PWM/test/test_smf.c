@@ -0,0 +1,176 @@
+#include <string.h>
+#include "smf.h"
+#include "smf_player.h"
+#include "test.h"
+
+typedef struct {
+    uint32_t tick;
+    uint32_t us;
+    uint8_t  track;
+    uint8_t  status, d1, d2;
+} want_t;
+
+// Format 1, 96 ticks per quarter, three tracks:
+//   0: 120 bpm, 240 bpm from tick 192
+//   1: notes on ch 1 in running status, then an explicit note-off
+//   2: a note on ch 2 in running status, overlapping track 1's run
+static const uint8_t ref_mid[] = {
+    'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 1, 0, 3, 0, 96,
+    'M', 'T', 'r', 'k', 0, 0, 0, 19,
+    0x00, 0xFF, 0x51, 0x03, 0x07, 0xA1, 0x20,
+    0x81, 0x40, 0xFF, 0x51, 0x03, 0x03, 0xD0, 0x90,
+    0x00, 0xFF, 0x2F, 0x00,
+    'M', 'T', 'r', 'k', 0, 0, 0, 18,
+    0x00, 0x90, 0x3C, 0x64,
+    0x60, 0x3C, 0x00,
+    0x60, 0x3E, 0x64,
+    0x60, 0x80, 0x3E, 0x00,
+    0x00, 0xFF, 0x2F, 0x00,
+    'M', 'T', 'r', 'k', 0, 0, 0, 12,
+    0x30, 0x91, 0x30, 0x50,
+    0x81, 0x70, 0x30, 0x00,
+    0x00, 0xFF, 0x2F, 0x00,
+};
+
+// Ties go to the lower track; times after tick 192 run at 2604.17 us/tick.
+static const want_t ref_events[] = {
+    {   0,       0, 0, 0xFF, 0x51, 0    },
+    {   0,       0, 1, 0x90, 0x3C, 0x64 },
+    {  48,  250000, 2, 0x91, 0x30, 0x50 },
+    {  96,  500000, 1, 0x90, 0x3C, 0x00 },
+    { 192, 1000000, 0, 0xFF, 0x51, 0    },
+    { 192, 1000000, 0, 0xFF, 0x2F, 0    },
+    { 192, 1000000, 1, 0x90, 0x3E, 0x64 },
+    { 288, 1250000, 1, 0x80, 0x3E, 0x00 },
+    { 288, 1250000, 1, 0xFF, 0x2F, 0    },
+    { 288, 1250000, 2, 0x91, 0x30, 0x00 },
+    { 288, 1250000, 2, 0xFF, 0x2F, 0    },
+};
+
+static void test_reference_file(void)
+{
+    smf_file_t f;
+    smf_event_t ev;
+    size_t n = 0;
+
+    CHECK_EQ(smf_open(&f, ref_mid, sizeof ref_mid), SMF_OK);
+    CHECK_EQ(f.format, 1);
+    CHECK_EQ(f.ntracks, 3);
+    CHECK_EQ(f.division, 96);
+
+    while (smf_next(&f, &ev)) {
+        if (n < sizeof ref_events / sizeof ref_events[0]) {
+            const want_t *w = &ref_events[n];
+            CHECK_EQ(ev.tick, w->tick);
+            CHECK_EQ(ev.time_us, w->us);
+            CHECK_EQ(ev.track, w->track);
+            CHECK_EQ(ev.status, w->status);
+            CHECK_EQ(ev.d1, w->d1);
+            CHECK_EQ(ev.d2, w->d2);
+        }
+        n++;
+    }
+    CHECK_EQ(n, sizeof ref_events / sizeof ref_events[0]);
+    CHECK_EQ(f.tempo, 250000);
+}
+
+static void test_bad_files(void)
+{
+    smf_file_t f;
+    uint8_t hdr[sizeof ref_mid];
+
+    memcpy(hdr, ref_mid, sizeof hdr);
+    hdr[9] = 2;                                 // format 2
+    CHECK_EQ(smf_open(&f, hdr, sizeof hdr), SMF_ERR_FORMAT);
+
+    memcpy(hdr, ref_mid, sizeof hdr);
+    hdr[12] = 0xE7;                             // SMPTE division
+    CHECK_EQ(smf_open(&f, hdr, sizeof hdr), SMF_ERR_FORMAT);
+
+    CHECK_EQ(smf_open(&f, ref_mid, 10), SMF_ERR_HEADER);
+    CHECK_EQ(smf_open(&f, ref_mid, sizeof ref_mid - 5), SMF_ERR_TRUNCATED);
+}
+
+typedef struct {
+    int      events;
+    int      note_ons[SMF_MAX_TRACKS];
+    uint8_t  status[SMF_MAX_TRACKS];            // the one channel status each track uses
+    bool     mixed;
+    int      held;                              // note-ons without their note-off
+    uint32_t last_tick, last_us;
+    bool     ordered;
+} song_stats_t;
+
+static song_stats_t walk_song(const smf_song_t *s, smf_file_t *f)
+{
+    song_stats_t st = { .ordered = true };
+    smf_event_t ev;
+    uint8_t on[16][128] = { { 0 } };
+
+    CHECK_EQ(smf_open(f, s->data, s->len), SMF_OK);
+    while (smf_next(f, &ev)) {
+        if (ev.tick < st.last_tick || ev.time_us < st.last_us) st.ordered = false;
+        st.last_tick = ev.tick;
+        st.last_us = ev.time_us;
+        st.events++;
+
+        if (ev.status >= 0xF0) continue;
+        uint8_t *held = &on[ev.status & 0x0F][ev.d1];
+        if (smf_is_note_on(&ev)) {
+            st.note_ons[ev.track]++;
+            (*held)++;
+        } else if (smf_is_note_off(&ev) && *held) {
+            (*held)--;
+        }
+        if (!st.status[ev.track]) st.status[ev.track] = ev.status;
+        else if ((st.status[ev.track] & 0x0F) != (ev.status & 0x0F)) st.mixed = true;
+    }
+    for (int c = 0; c < 16; c++)
+        for (int k = 0; k < 128; k++) st.held += on[c][k];
+    return st;
+}
+
+// Ode to Joy: tempo track with 500000 us/qn, 428571 from bar 5 (tick
+// 1536); melody on ch 1 and bass on ch 2, each in running status.
+static void test_ode_to_joy(void)
+{
+    smf_file_t f;
+    song_stats_t st = walk_song(&smf_songs[0], &f);
+
+    CHECK_EQ(f.format, 1);
+    CHECK_EQ(f.ntracks, 3);
+    CHECK(st.ordered);
+    CHECK(!st.mixed);
+    CHECK_EQ(st.note_ons[1], 30);
+    CHECK_EQ(st.note_ons[2], 10);
+    CHECK_EQ(st.status[1], 0x90);
+    CHECK_EQ(st.status[2], 0x91);
+    CHECK_EQ(st.held, 0);
+    CHECK_EQ(f.tempo, 428571);
+    CHECK_EQ(st.last_tick, 3064);
+    CHECK_EQ(st.last_us, 8000000 + (uint32_t)(1528ull * 428571 / 96));
+}
+
+// Scale: format 0 at 400000 us/qn, 15 notes of 48 ticks in running status.
+static void test_scale(void)
+{
+    smf_file_t f;
+    song_stats_t st = walk_song(&smf_songs[1], &f);
+
+    CHECK_EQ(f.format, 0);
+    CHECK_EQ(f.ntracks, 1);
+    CHECK(st.ordered);
+    CHECK_EQ(st.note_ons[0], 15);
+    CHECK_EQ(st.held, 0);
+    CHECK_EQ(st.last_tick, 14 * 48 + 40);
+    CHECK_EQ(st.last_us, (14 * 48 + 40) * 400000u / 96);
+}
+
+int main(void)
+{
+    test_reference_file();
+    test_bad_files();
+    test_ode_to_joy();
+    test_scale();
+    TEST_DONE("test_smf");
+}